@@ -0,0 +1,251 @@
+// Host benchmark of the game_of_life generations; see README.md.
+//
+// The component computes generations on bit-packed words and skips the tiles without changes
+// nearby. The stepper it replaced, on a vector of rows of one char per cell, is kept here as
+// the reference: both start from the same random board, are timed separately, and then
+// stepped side by side to check that every cell has the same age after every generation.
+#include "game_of_life.h"
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+using namespace esphome;
+using namespace esphome::game_of_life;
+
+/** Gives access to the board and to a single generation. */
+class BenchGame : public GameOfLife {
+ public:
+  BenchGame(int cols, int rows) {
+    this->set_size(cols, rows);
+    this->alive_ = 0;
+    this->topWeight_ = 0;
+    this->iteration_ = 0;
+    this->alive_same_count_ = 0;
+    this->restart_cycle_history_();
+  }
+
+  void step() { this->nextIteration(); }
+  char get_cell(int r, int c) { return this->get_cell_(r, c); }
+  /** Set a cell of the empty board, counting the population as reset() does. */
+  void set_cell(int r, int c, char age) {
+    this->set_cell_(r, c, age);
+    if (age != AGE_DEAD) {
+      this->alive_++;
+    }
+  }
+  /** Start the cycle detection from the board as it is now. */
+  void start_history() { this->restart_cycle_history_(); }
+};
+
+/** The stepper before bit-packing, one char per cell holding its age; the baseline. */
+class ReferenceGame {
+ public:
+  ReferenceGame(int cols, int rows)
+      : rows(rows), cols(cols), current_state_(rows, std::vector<char>(cols, AGE_DEAD)) {}
+
+  char get_cell(int r, int c) const { return this->current_state_[r][c]; }
+  void set_cell(int r, int c, char age) { this->current_state_[r][c] = age; }
+  uint get_population() const { return this->alive_; }
+
+  void step() {
+    int x;
+    int y;
+    char value;
+    std::vector<char> row(this->cols, AGE_DEAD);
+    row.shrink_to_fit();
+    auto next = std::vector<std::vector<char>>(this->rows, row);
+    next.shrink_to_fit();
+    uint weight = 0;  // total number of on-points
+
+    for (int r = 0; r < this->rows; r++) {    // for each row
+      for (int c = 0; c < this->cols; c++) {  // and each column
+        // count how many live neighbors this cell has
+        int live_neighbors = 0;
+        for (int i = -1; i < 2; i++) {
+          y = r + i;
+          if (y == -1) {
+            y = (this->rows - 1);
+          } else if (y == this->rows) {
+            y = 0;
+          }
+          for (int j = -1; j < 2; j++) {
+            if (i != 0 || j != 0) {
+              x = c + j;
+              if (x == -1) {
+                x = (this->cols - 1);
+              } else if (x == this->cols) {
+                x = 0;
+              }
+
+              if (this->current_state_[y][x]) {
+                live_neighbors++;
+              }
+            }
+          }
+        }
+
+        // apply the rules
+        if (this->current_state_[r][c] && live_neighbors >= 2 && live_neighbors <= 3) {
+          value = this->current_state_[r][c];
+          if (value < AGE_n) {
+            value++;
+          }
+          weight++;
+        } else if (!this->current_state_[r][c] && live_neighbors == 3) {
+          value = AGE_1;
+          weight++;
+        } else {
+          value = AGE_DEAD;
+        }
+
+        next[r][c] = value;
+      }
+    }
+
+    this->current_state_.swap(next);
+    this->alive_ = weight;
+  }
+
+ protected:
+  int rows, cols;
+  std::vector<std::vector<char>> current_state_;
+  uint alive_{0};
+};
+
+struct Options {
+  std::vector<std::pair<int, int>> sizes{{128, 64}};
+  int generations{1000};
+  int density{20};
+  unsigned seed{1};
+};
+
+/** Fill both boards with the same random cells, as GameOfLife::reset() does. */
+static void seed(BenchGame &game, ReferenceGame &reference, int cols, int rows, const Options &options) {
+  srand(options.seed);
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < cols; c++) {
+      char age = gol_random(1, 100) < options.density ? AGE_1 : AGE_DEAD;
+      game.set_cell(r, c, age);
+      reference.set_cell(r, c, age);
+    }
+  }
+  game.start_history();
+}
+
+template<typename Game> static double generations_per_second(Game &game, int generations) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < generations; i++) {
+    game.step();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return generations / std::max(seconds, 1e-9);
+}
+
+/** @return The first generation after which the boards differ, or 0 if they never do. */
+static int compare(int cols, int rows, const Options &options) {
+  BenchGame game(cols, rows);
+  ReferenceGame reference(cols, rows);
+  seed(game, reference, cols, rows, options);
+  for (int generation = 1; generation <= options.generations; generation++) {
+    game.step();
+    reference.step();
+    if (game.get_population() != reference.get_population()) {
+      return generation;
+    }
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < cols; c++) {
+        if (game.get_cell(r, c) != reference.get_cell(r, c)) {
+          return generation;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+static std::vector<std::string> split(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    items.push_back(item);
+  }
+  return items;
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --size WxH[,WxH...]  board sizes (default: 128x64)\n"
+          "  --generations N      generations timed and compared (default: 1000)\n"
+          "  --density N          starting density, as starting_density (default: 20)\n"
+          "  --seed N             seed of the starting board (default: 1)\n",
+          program);
+}
+
+static bool parse_options(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--size") {
+      options.sizes.clear();
+      for (auto &item : split(value)) {
+        int cols, rows;
+        if (sscanf(item.c_str(), "%dx%d", &cols, &rows) != 2 || cols < 1 || rows < 1) {
+          return false;
+        }
+        options.sizes.emplace_back(cols, rows);
+      }
+    } else if (arg == "--generations") {
+      options.generations = std::max(1, std::stoi(value));
+    } else if (arg == "--density") {
+      options.density = std::stoi(value);
+    } else if (arg == "--seed") {
+      options.seed = std::stoul(value);
+    } else {
+      return false;
+    }
+  }
+  return !options.sizes.empty();
+}
+
+}  // namespace bench
+
+int main(int argc, char **argv) {
+  using namespace bench;
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  printf("%-9s %11s %14s %14s %8s %10s %s\n", "board", "generations", "reference g/s", "component g/s", "speedup",
+         "population", "boards");
+  int failures = 0;
+  for (auto &size : options.sizes) {
+    int cols = size.first, rows = size.second;
+    BenchGame game(cols, rows);
+    ReferenceGame reference(cols, rows);
+    seed(game, reference, cols, rows, options);
+    double reference_rate = generations_per_second(reference, options.generations);
+    double game_rate = generations_per_second(game, options.generations);
+
+    int differs = compare(cols, rows, options);
+    std::string board = std::to_string(cols) + "x" + std::to_string(rows);
+    std::string boards = differs ? "differ after generation " + std::to_string(differs) : "identical";
+    printf("%-9s %11d %14.0f %14.0f %7.1fx %10u %s\n", board.c_str(), options.generations, reference_rate,
+           game_rate, game_rate / reference_rate, game.get_population(), boards.c_str());
+    if (differs) {
+      failures++;
+    }
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+// The parts of the esphome core the component uses, for running it on the host.
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+
+#include <chrono>
+#include <thread>
+
+namespace esphome {
+
+namespace setup_priority {
+const float PROCESSOR = 400.0f;
+}  // namespace setup_priority
+
+static const auto START = std::chrono::steady_clock::now();
+
+uint32_t millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - START).count();
+}
+
+uint32_t micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START).count();
+}
+
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+}  // namespace esphome
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+
+#include "esphome/core/color.h"
+
+namespace esphome {
+namespace display {
+
+/** Nothing is drawn on the host; the benchmark only computes generations. */
+class Display {
+ public:
+  virtual ~Display() = default;
+  virtual void draw_pixel_at(int x, int y, Color color) {}
+  virtual int get_width() { return 0; }
+  virtual int get_height() { return 0; }
+};
+
+}  // namespace display
+}  // namespace esphome
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+
+namespace esphome {
+
+struct Color {
+  union {
+    struct {
+      union {
+        uint8_t r;
+        uint8_t red;
+      };
+      union {
+        uint8_t g;
+        uint8_t green;
+      };
+      union {
+        uint8_t b;
+        uint8_t blue;
+      };
+      union {
+        uint8_t w;
+        uint8_t white;
+      };
+    };
+    uint32_t raw_32;
+  };
+
+  Color() : raw_32(0) {}
+  Color(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue), w(0xFF) {}
+  Color(uint8_t red, uint8_t green, uint8_t blue, uint8_t white) : r(red), g(green), b(blue), w(white) {}
+  bool operator==(const Color &rhs) const { return this->raw_32 == rhs.raw_32; }
+  bool operator!=(const Color &rhs) const { return this->raw_32 != rhs.raw_32; }
+};
+
+}  // namespace esphome
@@ -2,6 +2,8 @@
 #include "esphome/core/log.h"
 #include "esphome/core/hal.h"
 
+#include <algorithm>
+
 namespace esphome {
 namespace game_of_life {
 
@@ -27,10 +29,10 @@ void GameOfLife::reset() {
     for (int c = 0; c < this->cols; c++) {
       num = gol_random(1, 100);
       if (num < this->starting_density_) {
-        this->current_state_[r][c] = AGE_1;
+        this->set_cell_(r, c, AGE_1);
         this->alive_++;
       } else {
-        this->current_state_[r][c] = AGE_DEAD;
+        this->set_cell_(r, c, AGE_DEAD);
       }
     }
   }
@@ -39,22 +41,27 @@ void GameOfLife::reset() {
   this->topWeight_ = 0;
   this->iteration_ = 0;
   this->alive_same_count_ = 0;
+  this->restart_cycle_history_();
 }
 
 void GameOfLife::set_color_off(esphome::Color color) {
   this->color_off = color;
+  this->full_redraw_ = true;
 }
 
 void GameOfLife::set_color_age_1(esphome::Color color) {
   this->color_age_1 = color;
+  this->full_redraw_ = true;
 }
 
 void GameOfLife::set_color_age_2(esphome::Color color) {
   this->color_age_2 = color;
+  this->full_redraw_ = true;
 }
 
 void GameOfLife::set_color_age_n(esphome::Color color) {
   this->color_age_n = color;
+  this->full_redraw_ = true;
 }
 
 void GameOfLife::set_speed(uint8_t speed) {
@@ -70,11 +77,84 @@ void GameOfLife::set_size(int cols, int rows) {
   this->cols = cols;
   this->rows = rows;
 
-  std::vector<char> row(this->cols, AGE_DEAD);
-  row.shrink_to_fit();
-  // Initializing the 2-D vector
-	this->current_state_ = std::vector<std::vector<char>>(this->rows, row);
-  this->current_state_.shrink_to_fit();
+  this->words_per_row_ = (cols + CELL_WORD_BITS - 1) / CELL_WORD_BITS;
+  // bits past the last column must stay clear
+  int last_bits = cols - (this->words_per_row_ - 1) * CELL_WORD_BITS;
+  this->last_word_mask_ = last_bits == CELL_WORD_BITS ? ~cell_word_t(0) : (cell_word_t(1) << last_bits) - 1;
+
+  size_t words = this->rows * this->words_per_row_;
+  this->board_hash_ = 0;
+  for (size_t i = 0; i < words; i++) {
+    this->board_hash_ += this->hash_word_(0, i);
+  }
+  this->current_state_.alive.assign(words, 0);
+  this->current_state_.age_2.assign(words, 0);
+  this->current_state_.age_n.assign(words, 0);
+  this->next_state_ = this->current_state_;
+
+  this->tile_rows_ = (rows + TILE_ROWS - 1) / TILE_ROWS;
+  size_t tiles = this->tile_rows_ * this->words_per_row_;
+  this->tile_changed_.assign(tiles, 1);
+  this->next_tile_changed_.assign(tiles, 0);
+  this->tile_active_.assign(tiles, 1);
+  this->full_redraw_ = true;
+}
+
+char GameOfLife::get_cell_(int r, int c) {
+  int i = r * this->words_per_row_ + c / CELL_WORD_BITS;
+  cell_word_t bit = cell_word_t(1) << (c % CELL_WORD_BITS);
+  if (!(this->current_state_.alive[i] & bit)) {
+    return AGE_DEAD;
+  }
+  if (!(this->current_state_.age_2[i] & bit)) {
+    return AGE_1;
+  }
+  return (this->current_state_.age_n[i] & bit) ? AGE_n : AGE_2;
+}
+
+void GameOfLife::set_cell_(int r, int c, char age) {
+  int i = r * this->words_per_row_ + c / CELL_WORD_BITS;
+  cell_word_t bit = cell_word_t(1) << (c % CELL_WORD_BITS);
+  auto set_bit = [bit](cell_word_t &word, bool value) { word = value ? (word | bit) : (word & ~bit); };
+  this->board_hash_ -= this->hash_word_(this->current_state_.alive[i], i);
+  set_bit(this->current_state_.alive[i], age >= AGE_1);
+  this->board_hash_ += this->hash_word_(this->current_state_.alive[i], i);
+  set_bit(this->current_state_.age_2[i], age >= AGE_2);
+  set_bit(this->current_state_.age_n[i], age >= AGE_n);
+  // the next state of the tile, and of those around it, has to be computed again
+  this->tile_changed_[(r / TILE_ROWS) * this->words_per_row_ + c / CELL_WORD_BITS] = 1;
+}
+
+// mix of a word of the live cell plane and its position, summed up into board_hash_
+uint32_t GameOfLife::hash_word_(cell_word_t word, int i) {
+  uint32_t h = word ^ (i * UINT32_C(0x9E3779B9));
+  // murmur3 finalizer
+  h ^= h >> 16;
+  h *= UINT32_C(0x85EBCA6B);
+  h ^= h >> 13;
+  h *= UINT32_C(0xC2B2AE35);
+  h ^= h >> 16;
+  return h;
+}
+
+// word of the left neighbours of the cells in word w, wrapping around the board
+cell_word_t GameOfLife::west_(const cell_word_t *row, int w) {
+  cell_word_t carry;
+  if (w > 0) {
+    carry = row[w - 1] >> (CELL_WORD_BITS - 1);
+  } else {
+    carry = (row[this->words_per_row_ - 1] >> ((this->cols - 1) % CELL_WORD_BITS)) & 1;
+  }
+  return (row[w] << 1) | carry;
+}
+
+// word of the right neighbours of the cells in word w, wrapping around the board
+cell_word_t GameOfLife::east_(const cell_word_t *row, int w) {
+  if (w < this->words_per_row_ - 1) {
+    return (row[w] >> 1) | (row[w + 1] << (CELL_WORD_BITS - 1));
+  }
+  // the last column sees the first one
+  return (row[w] >> 1) | ((row[0] & 1) << ((this->cols - 1) % CELL_WORD_BITS));
 }
 
 void GameOfLife::set_starting_density(int starting_density) {
@@ -97,26 +177,63 @@ uint8_t GameOfLife::get_speed() {
   return this->speed_;
 }
 
+esphome::Color GameOfLife::get_color_(char age) {
+  switch(age) {
+    case AGE_1:
+      return color_age_1;
+    case AGE_2:
+      return color_age_2;
+    case AGE_n:
+      return color_age_n;
+  }
+  return color_off;
+}
+
 void GameOfLife::draw(display::Display & display, int x, int y) {
   this->mutex_.lock();
+  this->draw_all_(display, x, y);
+  this->mutex_.unlock();
+}
 
+void GameOfLife::draw_all_(display::Display & display, int x, int y) {
   for (int r = 0; r < this->rows; r++) {     // for each row
     for (int c = 0; c < this->cols; c++) {   // and each column
-      auto value = this->current_state_[r][c];
-      auto color = color_off;
-      switch(value) {
-        case AGE_1:
-          color = color_age_1;
-          break;
-        case AGE_2:
-          color = color_age_2;
-          break;
-        case AGE_n:
-          color = color_age_n;
-          break;
-      }
-      display.draw_pixel_at(x+c,y+r,color);
+      display.draw_pixel_at(x+c,y+r,this->get_color_(this->get_cell_(r, c)));
+    }
+  }
+}
+
+void GameOfLife::draw_changes(display::Display & display, int x, int y) {
+  this->mutex_.lock();
+  if (this->full_redraw_ || this->drawn_display_ != &display || this->drawn_x_ != x || this->drawn_y_ != y) {
+    this->draw_all_(display, x, y);
+    // remember what is on the display; only allocated once draw_changes() is used
+    this->drawn_state_.alive = this->current_state_.alive;
+    this->drawn_state_.age_2 = this->current_state_.age_2;
+    this->drawn_state_.age_n = this->current_state_.age_n;
+    this->drawn_display_ = &display;
+    this->drawn_x_ = x;
+    this->drawn_y_ = y;
+    this->full_redraw_ = false;
+    this->mutex_.unlock();
+    return;
+  }
 
+  const int wpr = this->words_per_row_;
+  for (int r = 0; r < this->rows; r++) {     // for each row
+    for (int w = 0; w < wpr; w++) {          // and each word of CELL_WORD_BITS columns
+      int i = r * wpr + w;
+      cell_word_t changed = (this->current_state_.alive[i] ^ this->drawn_state_.alive[i]) |
+                            (this->current_state_.age_2[i] ^ this->drawn_state_.age_2[i]) |
+                            (this->current_state_.age_n[i] ^ this->drawn_state_.age_n[i]);
+      while (changed) {
+        int c = w * CELL_WORD_BITS + __builtin_ctz(changed);
+        changed &= changed - 1;
+        display.draw_pixel_at(x+c,y+r,this->get_color_(this->get_cell_(r, c)));
+      }
+      this->drawn_state_.alive[i] = this->current_state_.alive[i];
+      this->drawn_state_.age_2[i] = this->current_state_.age_2[i];
+      this->drawn_state_.age_n[i] = this->current_state_.age_n[i];
     }
   }
   this->mutex_.unlock();
@@ -133,8 +250,9 @@ void GameOfLife::spark_of_life() {
       num = gol_random(1, 100);
 
       value = num >= 90;
-      if (value == 1 && this->current_state_[r][c] == AGE_DEAD) {              // only add new points, don't remove any
-        this->current_state_[r][c] = AGE_1;
+      if (value == 1 && this->get_cell_(r, c) == AGE_DEAD) {              // only add new points, don't remove any
+        this->set_cell_(r, c, AGE_1);
+        this->alive_++;
       }
     }
   }
@@ -142,63 +260,85 @@ void GameOfLife::spark_of_life() {
 }
 
 void GameOfLife::nextIteration() {
-  int x;
-  int y;
-  char value;
-  std::vector<char> row(this->cols, AGE_DEAD);
-  row.shrink_to_fit();
-	auto next = std::vector<std::vector<char>>(this->rows, row);
-  next.shrink_to_fit();
-  uint weight = 0;   //total number of on-points
+  const int wpr = this->words_per_row_;
+  Generation &next = this->next_state_;
+  uint weight = this->alive_;   //total number of on-points, updated for the words that are recomputed
+
+  // Cells can only change next to cells that changed. Tiles without changes around them are
+  // skipped: next_state_ still holds the previous generation, which is the same there.
+  for (int tr = 0; tr < this->tile_rows_; tr++) {
+    // tiles above and below
+    const uint8_t *changed = &this->tile_changed_[tr * wpr];
+    const uint8_t *above = &this->tile_changed_[(tr == 0 ? this->tile_rows_ - 1 : tr - 1) * wpr];
+    const uint8_t *below = &this->tile_changed_[(tr == this->tile_rows_ - 1 ? 0 : tr + 1) * wpr];
+    uint8_t *active = &this->tile_active_[tr * wpr];
+    for (int tw = 0; tw < wpr; tw++) {
+      active[tw] = above[tw] | changed[tw] | below[tw];
+    }
+    // then tiles to the left and right
+    uint8_t first = active[0], left = active[wpr - 1];
+    for (int tw = 0; tw < wpr; tw++) {
+      uint8_t center = active[tw];
+      active[tw] = left | center | (tw == wpr - 1 ? first : active[tw + 1]);
+      left = center;
+    }
+  }
+  std::fill(this->next_tile_changed_.begin(), this->next_tile_changed_.end(), 0);
 
+  const cell_word_t *alive = this->current_state_.alive.data();
   for (int r = 0; r < this->rows; r++) {     // for each row
-    for (int c = 0; c < this->cols; c++) {   // and each column
-      // count how many live neighbors this cell has
-      int liveNeighbors = 0;
-      for (int i = -1; i < 2; i++) {
-        y = r + i;
-        if (y == -1) {
-          y = (this->rows-1);
-        } else if (y == this->rows) {
-          y = 0;
-        }
-        for (int j = -1; j < 2; j++) {
-          if (i != 0 || j != 0) {
-            x = c + j;
-            if (x == -1) {
-              x = (this->cols-1);
-            } else if (x == this->cols) {
-              x = 0;
-            }
-
-            if (this->current_state_[y][x]) {
-              liveNeighbors++;
-            }
-          }
-        }
+    const cell_word_t *above = alive + ((r == 0 ? this->rows : r) - 1) * wpr;
+    const cell_word_t *row = alive + r * wpr;
+    const cell_word_t *below = alive + (r == this->rows - 1 ? 0 : r + 1) * wpr;
+    const uint8_t *tile_active = &this->tile_active_[(r / TILE_ROWS) * wpr];
+    uint8_t *tile_changed = &this->next_tile_changed_[(r / TILE_ROWS) * wpr];
+    for (int w = 0; w < wpr; w++) {          // and each word of CELL_WORD_BITS columns
+      if (!tile_active[w]) {
+        continue;
       }
-
-      // apply the rules
-      if (this->current_state_[r][c] && liveNeighbors >= 2 && liveNeighbors <= 3) { // live cells with 2 or 3 neighbors remain alive
-        value = this->current_state_[r][c];
-        if (value < AGE_n) {
-          value++;
-        }
-        weight++;
-      } else if (!this->current_state_[r][c] && liveNeighbors == 3) { // dead cells with 3 neighbors become alive
-        value = AGE_1;
-        weight++;
-      } else {
-        value = AGE_DEAD;
+      cell_word_t neighbors[8] = {
+          this->west_(above, w), above[w], this->east_(above, w),
+          this->west_(row, w),             this->east_(row, w),
+          this->west_(below, w), below[w], this->east_(below, w),
+      };
+
+      // count the live neighbors of all cells of the word at once, as a 3 bit number per cell
+      // (8 neighbors wrap around to 0, which is as dead as it gets anyway)
+      cell_word_t s0 = 0, s1 = 0, s2 = 0;
+      for (auto n : neighbors) {
+        cell_word_t c0 = s0 & n;
+        s0 ^= n;
+        cell_word_t c1 = s1 & c0;
+        s1 ^= c0;
+        s2 ^= c1;
       }
 
-      next[r][c] = value;
+      // apply the rules: live cells with 2 or 3 neighbors remain alive, dead cells with 3 neighbors become alive
+      int i = r * wpr + w;
+      cell_word_t live = ~s2 & s1 & (s0 | row[w]);
+      if (w == wpr - 1) {
+        live &= this->last_word_mask_;
+      }
+      cell_word_t survivors = live & row[w];
+      next.alive[i] = live;
+      next.age_2[i] = survivors;
+      next.age_n[i] = survivors & this->current_state_.age_2[i];
+      if (live != row[w] || survivors != this->current_state_.age_2[i] ||
+          next.age_n[i] != this->current_state_.age_n[i]) {
+        tile_changed[w] = 1;
+        weight += __builtin_popcount(live);
+        weight -= __builtin_popcount(row[w]);
+        this->board_hash_ += this->hash_word_(live, i) - this->hash_word_(row[w], i);
+      }
     }
   }
 
   // discard the old state and keep the new one
   this->mutex_.lock();
-  this->current_state_.swap(next);
+  this->current_state_.alive.swap(next.alive);
+  this->current_state_.age_2.swap(next.age_2);
+  this->current_state_.age_n.swap(next.age_n);
+  this->tile_changed_.swap(this->next_tile_changed_);
   if (this->alive_ == weight) {
     this->alive_same_count_++;
   } else {
@@ -208,19 +348,45 @@ void GameOfLife::nextIteration() {
   this->mutex_.unlock();
 
   this->iteration_++;
+  this->find_cycle_();
 
   if (weight >= this->topWeight_) this->topWeight_=weight;
 }
 
+// forget the past generations, starting over from the board as it is now
+void GameOfLife::restart_cycle_history_() {
+  this->cycle_period_ = 0;
+  this->hash_history_[this->iteration_ % CYCLE_HISTORY] = this->board_hash_;
+  this->hash_history_size_ = 1;
+}
+
+void GameOfLife::find_cycle_() {
+  // the board repeats if its hash is one of the last generations'
+  this->cycle_period_ = 0;
+  for (uint period = 1; period <= this->hash_history_size_; period++) {
+    if (this->hash_history_[(this->iteration_ - period) % CYCLE_HISTORY] == this->board_hash_) {
+      this->cycle_period_ = period;
+      break;
+    }
+  }
+  this->hash_history_[this->iteration_ % CYCLE_HISTORY] = this->board_hash_;
+  if (this->hash_history_size_ < CYCLE_HISTORY) {
+    this->hash_history_size_++;
+  }
+}
+
 void GameOfLife::loop() {
   if (!this->running_) return;
 
   // do not iterate game state when running spark_of_life, or the component will take too long
   // if the number of alive cells has remained constant for a while, add some random mutations to keep things interesting
-  if (this->run_spark_ && alive_same_count_ > ((this->cols*this->rows) /6)) {
-    ESP_LOGD(TAG, "SparkOfLife:  alive_same_count_: %d iteration: %d", this->alive_same_count_, this->iteration_);
+  // cycles longer than CYCLE_HISTORY, like gliders crossing the board, are caught by the steady population
+  if (this->run_spark_ && (this->cycle_period_ > 0 || alive_same_count_ > ((this->cols*this->rows) /6))) {
+    ESP_LOGD(TAG, "SparkOfLife:  alive_same_count_: %d cycle: %d iteration: %d", this->alive_same_count_,
+             this->cycle_period_, this->iteration_);
     this->alive_same_count_ = 0;
     if ( this->iteration_ > 20) this->spark_of_life();  
+    this->restart_cycle_history_();
   } else {
 
     // check if this should run based on speed
@@ -4,6 +4,8 @@
 #include "esphome/core/color.h"
 #include "esphome/core/preferences.h"
 
+#include <array>
+
 #define AGE_DEAD 0
 #define AGE_1 1
 #define AGE_2 2
@@ -27,6 +29,22 @@ const auto color_age_1 = esphome::Color(0,128,0);
 const auto color_age_2 = esphome::Color(128,0,0); 
 const auto color_age_n = esphome::Color(0,0,128);
 
+// cells are packed in words, one bit per cell, least significant bit first
+typedef uint32_t cell_word_t;
+const int CELL_WORD_BITS = 32;
+// the board is split in tiles of one word by TILE_ROWS rows, which are only recomputed when active;
+// single rows skip the most work, taller tiles are recomputed for any change anywhere in them
+const int TILE_ROWS = 1;
+// number of past board hashes kept, which is the longest cycle that is detected
+const int CYCLE_HISTORY = 64;
+
+// one bit-plane per age threshold, so the age of a cell follows from its bits
+struct Generation {
+    std::vector<cell_word_t> alive;  // AGE_1 or older
+    std::vector<cell_word_t> age_2;  // AGE_2 or older
+    std::vector<cell_word_t> age_n;  // AGE_n
+};
+
 class GameOfLife : public Component {
     public:
         GameOfLife();
@@ -52,6 +70,11 @@ class GameOfLife : public Component {
         void spark_of_life();
         void reset();
         void draw(display::Display&, int, int);
+        // only draw the cells that changed since the last draw, for displays that keep their content
+        // (auto_clear_enabled: false); the first call, and the first after redraw(), draws everything.
+        // displays do not report when they are cleared, so call redraw() after clearing one
+        void draw_changes(display::Display&, int, int);
+        void redraw() { this->full_redraw_ = true; };
         void start() { this->running_ = true; };
         void stop() { this->running_ = false; };
 
@@ -68,13 +91,43 @@ class GameOfLife : public Component {
 
     protected:
         void nextIteration();
+        void draw_all_(display::Display&, int, int);
+        esphome::Color get_color_(char age);
+        char get_cell_(int r, int c);
+        void set_cell_(int r, int c, char age);
+        cell_word_t west_(const cell_word_t *row, int w);
+        cell_word_t east_(const cell_word_t *row, int w);
+        uint32_t hash_word_(cell_word_t word, int i);
+        void find_cycle_();
+        void restart_cycle_history_();
         int64_t get_time_ns_();
         void set_next_call_ns_();
         uint8_t speed_;
         esphome::Color color_off, color_age_1, color_age_2, color_age_n;
         uint starting_density_;
-        std::vector<std::vector<char>> current_state_;
+        Generation current_state_;
+        // allocated once with the board, and swapped with current_state_ every generation
+        Generation next_state_;
+        // per tile: whether any of its cells changed in the last generation, and during the next one
+        std::vector<uint8_t> tile_changed_, next_tile_changed_;
+        // per tile: whether it or a neighbouring tile changed in the last generation
+        std::vector<uint8_t> tile_active_;
+        int tile_rows_;
+        // the board as last drawn by draw_changes(), and where; empty until draw_changes() is used
+        Generation drawn_state_;
+        display::Display *drawn_display_{nullptr};
+        int drawn_x_, drawn_y_;
+        bool full_redraw_ = true;
+        // sum of hash_word_() over the live cell plane, updated as words change
+        uint32_t board_hash_{0};
+        // hashes of the last generations, indexed by iteration_ % CYCLE_HISTORY
+        std::array<uint32_t, CYCLE_HISTORY> hash_history_;
+        uint hash_history_size_{0};
+        // period of the cycle the board is in, 0 if none was found
+        uint cycle_period_{0};
         int rows, cols;
+        int words_per_row_;
+        cell_word_t last_word_mask_;
         uint iteration_;
         uint alive_, alive_same_count_, topWeight_;
         esphome::Mutex mutex_;
@@ -15,6 +15,7 @@ from esphome.components.animation import (
     Animation_,
 )
 import esphome.config_validation as cv
+from esphome.core import CORE
 from esphome.const import (
     CONF_BUFFER_SIZE,
     CONF_DITHER,
@@ -23,9 +24,12 @@ from esphome.const import (
     CONF_ID,
     CONF_ON_ERROR,
     CONF_RESIZE,
+    CONF_SIZE,
     CONF_TRIGGER_ID,
     CONF_TYPE,
     CONF_URL,
+    CONF_X,
+    CONF_Y,
 )
 
 AUTO_LOAD = ["image", "animation"]
@@ -35,12 +39,33 @@ MULTI_CONF = True
 
 CONF_ON_DOWNLOAD_FINISHED = "on_download_finished"
 CONF_PLACEHOLDER = "placeholder"
+CONF_COMPRESS_FRAMES = "compress_frames"
+CONF_RESIZE_FILTER = "resize_filter"
+CONF_BACKGROUND_DECODE = "background_decode"
+CONF_MAX_BUFFER_SIZE = "max_buffer_size"
+CONF_AUTO_FORMATS = "auto_formats"
+CONF_CACHE = "cache"
+CONF_DOUBLE_BUFFER = "double_buffer"
+CONF_PROGRESSIVE = "progressive"
+CONF_ON_DEMAND_FRAMES = "on_demand_frames"
+CONF_INDEXED = "indexed"
+CONF_VIEWPORT = "viewport"
+CONF_MAX_SIZE = "max_size"
+CONF_MAX_AGE = "max_age"
+CONF_AUTOPLAY = "autoplay"
+CONF_ON_FRAME_CHANGED = "on_frame_changed"
 
 _LOGGER = logging.getLogger(__name__)
 
 online_image_ns = cg.esphome_ns.namespace("online_image")
 
 ImageFormat = online_image_ns.enum("ImageFormat")
+ResizeFilter = online_image_ns.enum("ResizeFilter")
+
+RESIZE_FILTERS = {
+    "NEAREST": ResizeFilter.RESIZE_FILTER_NEAREST,
+    "SMOOTH": ResizeFilter.RESIZE_FILTER_SMOOTH,
+}
 
 
 class Format:
@@ -108,6 +133,11 @@ class WEBPFormat(Format):
         #cg.add_platformio_option("lib_build_src_dir", ".")
 
 
+class AUTOFormat(Format):
+    def __init__(self):
+        super().__init__("AUTO")
+
+
 class PNGFormat(Format):
     def __init__(self):
         super().__init__("PNG")
@@ -117,6 +147,22 @@ class PNGFormat(Format):
         cg.add_library("pngle", "1.0.2")
 
 
+class QOIFormat(Format):
+    def __init__(self):
+        super().__init__("QOI")
+
+    def actions(self):
+        cg.add_define("USE_ONLINE_IMAGE_QOI_SUPPORT")
+
+
+class GIFFormat(Format):
+    def __init__(self):
+        super().__init__("GIF")
+
+    def actions(self):
+        cg.add_define("USE_ONLINE_IMAGE_GIF_SUPPORT")
+
+
 IMAGE_FORMATS = {
     x.image_type: x
     for x in (
@@ -124,16 +170,25 @@ IMAGE_FORMATS = {
         JPEGFormat(),
         WEBPFormat(),
         PNGFormat(),
+        QOIFormat(),
+        GIFFormat(),
+        AUTOFormat(),
     )
 }
 IMAGE_FORMATS.update({"JPG": IMAGE_FORMATS["JPEG"]})
 
+# Formats that can be told apart when the format is AUTO
+AUTO_FORMATS = ["BMP", "GIF", "JPEG", "PNG", "QOI", "WEBP"]
+
 OnlineImage = online_image_ns.class_("OnlineImage", cg.PollingComponent, Image_, Animation_)
 
 # Actions
 SetUrlAction = online_image_ns.class_(
     "OnlineImageSetUrlAction", automation.Action, cg.Parented.template(OnlineImage)
 )
+SetViewportAction = online_image_ns.class_(
+    "OnlineImageSetViewportAction", automation.Action, cg.Parented.template(OnlineImage)
+)
 ReleaseImageAction = online_image_ns.class_(
     "OnlineImageReleaseAction", automation.Action, cg.Parented.template(OnlineImage)
 )
@@ -145,6 +200,9 @@ DownloadFinishedTrigger = online_image_ns.class_(
 DownloadErrorTrigger = online_image_ns.class_(
     "DownloadErrorTrigger", automation.Trigger.template()
 )
+FrameChangedTrigger = online_image_ns.class_(
+    "FrameChangedTrigger", automation.Trigger.template()
+)
 
 
 def remove_options(*options):
@@ -165,8 +223,40 @@ ONLINE_IMAGE_SCHEMA = (
             # Online Image specific options
             cv.Required(CONF_URL): cv.url,
             cv.Required(CONF_FORMAT): cv.one_of(*IMAGE_FORMATS, upper=True),
+            cv.Optional(CONF_AUTO_FORMATS): cv.All(
+                cv.ensure_list(cv.one_of(*AUTO_FORMATS, "JPG", upper=True)),
+                cv.Length(min=1),
+            ),
             cv.Optional(CONF_PLACEHOLDER): cv.use_id(Image_),
             cv.Optional(CONF_BUFFER_SIZE, default=65536): cv.int_range(256, 65536),
+            cv.Optional(CONF_MAX_BUFFER_SIZE, default="512kB"): cv.All(
+                cv.validate_bytes, cv.int_range(min=256)
+            ),
+            cv.Optional(CONF_COMPRESS_FRAMES, default=False): cv.boolean,
+            cv.Optional(CONF_BACKGROUND_DECODE, default=False): cv.boolean,
+            cv.Optional(CONF_DOUBLE_BUFFER, default=False): cv.boolean,
+            cv.Optional(CONF_PROGRESSIVE, default=False): cv.boolean,
+            cv.Optional(CONF_ON_DEMAND_FRAMES, default=False): cv.boolean,
+            cv.Optional(CONF_INDEXED, default=False): cv.boolean,
+            cv.Optional(CONF_AUTOPLAY, default=False): cv.boolean,
+            cv.Optional(CONF_VIEWPORT): cv.Schema(
+                {
+                    cv.Required(CONF_SIZE): cv.dimensions,
+                    cv.Optional(CONF_X, default=0): cv.int_range(min=0),
+                    cv.Optional(CONF_Y, default=0): cv.int_range(min=0),
+                }
+            ),
+            cv.Optional(CONF_RESIZE_FILTER, default="NEAREST"): cv.enum(
+                RESIZE_FILTERS, upper=True
+            ),
+            cv.Optional(CONF_CACHE): cv.Schema(
+                {
+                    cv.Required(CONF_MAX_SIZE): cv.validate_bytes,
+                    cv.Optional(
+                        CONF_MAX_AGE, default="0s"
+                    ): cv.positive_time_period_milliseconds,
+                }
+            ),
             cv.Optional(CONF_ON_DOWNLOAD_FINISHED): automation.validate_automation(
                 {
                     cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(
@@ -179,14 +269,72 @@ ONLINE_IMAGE_SCHEMA = (
                     cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(DownloadErrorTrigger),
                 }
             ),
+            cv.Optional(CONF_ON_FRAME_CHANGED): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(FrameChangedTrigger),
+                }
+            ),
         }
     )
     .extend(cv.polling_component_schema("never"))
 )
 
+def _validate_auto_formats(config):
+    if CONF_AUTO_FORMATS in config and config[CONF_FORMAT] != "AUTO":
+        raise cv.Invalid(
+            f"{CONF_AUTO_FORMATS} can only be used with format AUTO",
+            path=[CONF_AUTO_FORMATS],
+        )
+    return config
+
+
+def _validate_background_decode(config):
+    if config[CONF_BACKGROUND_DECODE] and not CORE.is_esp32:
+        raise cv.Invalid(
+            f"{CONF_BACKGROUND_DECODE} is only supported on ESP32",
+            path=[CONF_BACKGROUND_DECODE],
+        )
+    return config
+
+
+def _validate_progressive(config):
+    if config[CONF_PROGRESSIVE]:
+        for option in (CONF_DOUBLE_BUFFER, CONF_BACKGROUND_DECODE):
+            if config[option]:
+                raise cv.Invalid(
+                    f"{CONF_PROGRESSIVE} can not be combined with {option}",
+                    path=[CONF_PROGRESSIVE],
+                )
+    return config
+
+
+def _validate_indexed(config):
+    # Binary and grayscale images already use at most one byte per pixel
+    if config[CONF_INDEXED] and config[CONF_TYPE] not in ("RGB", "RGB565"):
+        raise cv.Invalid(
+            f"{CONF_INDEXED} can only be used with type RGB or RGB565",
+            path=[CONF_INDEXED],
+        )
+    return config
+
+
+def _validate_viewport(config):
+    if CONF_VIEWPORT in config and CONF_RESIZE in config:
+        raise cv.Invalid(
+            f"{CONF_VIEWPORT} can not be combined with {CONF_RESIZE}; the viewport is not scaled",
+            path=[CONF_VIEWPORT],
+        )
+    return config
+
+
 CONFIG_SCHEMA = cv.Schema(
     cv.All(
         ONLINE_IMAGE_SCHEMA,
+        _validate_auto_formats,
+        _validate_background_decode,
+        _validate_progressive,
+        _validate_indexed,
+        _validate_viewport,
         cv.require_framework_version(
             # esp8266 not supported yet; if enabled in the future, minimum version of 2.7.0 is needed
             # esp8266_arduino=cv.Version(2, 7, 0),
@@ -205,6 +353,14 @@ SET_URL_SCHEMA = cv.Schema(
     }
 )
 
+SET_VIEWPORT_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(OnlineImage),
+        cv.Required(CONF_X): cv.templatable(cv.int_range(min=0)),
+        cv.Required(CONF_Y): cv.templatable(cv.int_range(min=0)),
+    }
+)
+
 RELEASE_IMAGE_SCHEMA = automation.maybe_simple_id(
     {
         cv.GenerateID(): cv.use_id(OnlineImage),
@@ -228,12 +384,35 @@ async def online_image_action_to_code(config, action_id, template_arg, args):
     return var
 
 
+@automation.register_action(
+    "online_image.set_viewport",
+    SetViewportAction,
+    SET_VIEWPORT_SCHEMA,
+    synchronous=True,
+)
+async def online_image_set_viewport_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    x = await cg.templatable(config[CONF_X], args, cg.int_)
+    y = await cg.templatable(config[CONF_Y], args, cg.int_)
+    cg.add(var.set_x(x))
+    cg.add(var.set_y(y))
+    return var
+
+
 async def to_code(config):
     image_format = IMAGE_FORMATS[config[CONF_FORMAT]]
     image_format.actions()
+    if config[CONF_FORMAT] == "AUTO":
+        # Only compile in the decoders the image may need
+        for auto_format in config.get(CONF_AUTO_FORMATS, AUTO_FORMATS):
+            IMAGE_FORMATS[auto_format].actions()
 
     url = config[CONF_URL]
     width, height = config.get(CONF_RESIZE, (0, 0))
+    if viewport := config.get(CONF_VIEWPORT):
+        # The buffer has the size of the viewport
+        width, height = viewport[CONF_SIZE]
     transparent = get_transparency_enum(config[CONF_TRANSPARENCY])
 
     var = cg.new_Pvariable(
@@ -248,6 +427,21 @@ async def to_code(config):
     )
     await cg.register_component(var, config)
     await cg.register_parented(var, config[CONF_HTTP_REQUEST_ID])
+    cg.add(var.set_max_download_buffer_size(config[CONF_MAX_BUFFER_SIZE]))
+    cg.add(var.set_compress_frames(config[CONF_COMPRESS_FRAMES]))
+    cg.add(var.set_resize_filter(config[CONF_RESIZE_FILTER]))
+    cg.add(var.set_double_buffer(config[CONF_DOUBLE_BUFFER]))
+    cg.add(var.set_progressive(config[CONF_PROGRESSIVE]))
+    cg.add(var.set_on_demand_frames(config[CONF_ON_DEMAND_FRAMES]))
+    cg.add(var.set_indexed(config[CONF_INDEXED]))
+    cg.add(var.set_autoplay(config[CONF_AUTOPLAY]))
+    if viewport := config.get(CONF_VIEWPORT):
+        cg.add(var.set_viewport(viewport[CONF_X], viewport[CONF_Y]))
+    if cache := config.get(CONF_CACHE):
+        cg.add(var.set_cache(cache[CONF_MAX_SIZE], cache[CONF_MAX_AGE]))
+    if config[CONF_BACKGROUND_DECODE]:
+        cg.add_define("USE_ONLINE_IMAGE_BACKGROUND_DECODE")
+        cg.add(var.set_background_decode(True))
 
     if placeholder_id := config.get(CONF_PLACEHOLDER):
         placeholder = await cg.get_variable(placeholder_id)
@@ -260,3 +454,7 @@ async def to_code(config):
     for conf in config.get(CONF_ON_ERROR, []):
         trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
         await automation.build_automation(trigger, [], conf)
+
+    for conf in config.get(CONF_ON_FRAME_CHANGED, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [], conf)
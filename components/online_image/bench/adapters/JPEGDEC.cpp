@@ -0,0 +1,107 @@
+// The JPEGDEC API used by the component, over libjpeg.
+#include "JPEGDEC.h"
+
+#include <cstdio>
+#include <jpeglib.h>
+
+#include <algorithm>
+#include <csetjmp>
+#include <vector>
+
+// JPEGDEC draws blocks of a few MCUs; this is close to its block size.
+static const int BLOCK_WIDTH = 128;
+
+struct JPEGDEC::State {
+  jpeg_decompress_struct info;
+  jpeg_error_mgr error;
+  jmp_buf jump;
+};
+
+static void error_exit(j_common_ptr info) { longjmp(*static_cast<jmp_buf *>(info->client_data), 1); }
+
+static void output_message(j_common_ptr info) {}
+
+int JPEGDEC::openRAM(uint8_t *pData, int iDataSize, JPEG_DRAW_CALLBACK pfnDraw) {
+  this->close();
+  this->state_ = new State();
+  jpeg_decompress_struct &info = this->state_->info;
+  info.err = jpeg_std_error(&this->state_->error);
+  this->state_->error.error_exit = error_exit;
+  this->state_->error.output_message = output_message;
+  info.client_data = &this->state_->jump;
+  if (setjmp(this->state_->jump)) {
+    this->last_error_ = this->state_->error.msg_code;
+    this->close();
+    return 0;
+  }
+  jpeg_create_decompress(&info);
+  jpeg_mem_src(&info, pData, iDataSize);
+  jpeg_read_header(&info, TRUE);
+  this->draw_ = pfnDraw;
+  this->width_ = info.image_width;
+  this->height_ = info.image_height;
+  this->bpp_ = 8 * info.num_components;
+  this->type_ = info.progressive_mode ? JPEG_MODE_PROGRESSIVE : JPEG_MODE_BASELINE;
+  return 1;
+}
+
+void JPEGDEC::close() {
+  if (this->state_) {
+    jpeg_destroy_decompress(&this->state_->info);
+    delete this->state_;
+    this->state_ = nullptr;
+  }
+}
+
+int JPEGDEC::decode(int x, int y, int iOptions) {
+  if (!this->state_ || this->pixel_type_ != RGB8888) {
+    return 0;
+  }
+  jpeg_decompress_struct &info = this->state_->info;
+  // Declared before setjmp, so that they keep their values after an error
+  std::vector<uint8_t> rgb;
+  std::vector<uint32_t> pixels;
+  if (setjmp(this->state_->jump)) {
+    this->last_error_ = this->state_->error.msg_code;
+    return 0;
+  }
+  info.out_color_space = JCS_RGB;
+  jpeg_start_decompress(&info);
+  // Rows of a whole MCU at a time
+  int rows = info.max_v_samp_factor * DCTSIZE;
+  int width = info.output_width;
+  rgb.resize(size_t(width) * 3 * rows);
+  pixels.resize(size_t(BLOCK_WIDTH) * rows);
+  std::vector<JSAMPROW> lines(rows);
+  for (int i = 0; i < rows; i++) {
+    lines[i] = &rgb[size_t(i) * width * 3];
+  }
+  while (info.output_scanline < info.output_height) {
+    int top = info.output_scanline;
+    int height = 0;
+    while (height < rows && info.output_scanline < info.output_height) {
+      height += jpeg_read_scanlines(&info, &lines[height], rows - height);
+    }
+    for (int left = 0; left < width; left += BLOCK_WIDTH) {
+      int block_width = std::min(BLOCK_WIDTH, width - left);
+      uint8_t *out = reinterpret_cast<uint8_t *>(pixels.data());
+      for (int j = 0; j < height; j++) {
+        const uint8_t *in = lines[j] + left * 3;
+        for (int i = 0; i < block_width; i++, in += 3, out += 4) {
+          out[0] = in[0];
+          out[1] = in[1];
+          out[2] = in[2];
+          out[3] = 0xFF;
+        }
+      }
+      JPEGDRAW draw{left, top, block_width, height, block_width, 32, reinterpret_cast<uint16_t *>(pixels.data()),
+                    this->user_};
+      if (!this->draw_(&draw)) {
+        jpeg_abort_decompress(&info);
+        return 0;
+      }
+    }
+  }
+  jpeg_finish_decompress(&info);
+  return 1;
+}
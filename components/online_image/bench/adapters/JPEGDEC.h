@@ -0,0 +1,59 @@
+// The JPEGDEC API used by the component, over the system libjpeg; see README.md.
+//
+// Only for building the benchmark without downloading JPEGDEC. Its times are those of libjpeg.
+#pragma once
+#include <cstdint>
+
+enum {
+  RGB565_LITTLE_ENDIAN = 0,
+  RGB565_BIG_ENDIAN,
+  EIGHT_BIT_GRAYSCALE,
+  RGB8888,
+};
+
+#define JPEG_MODE_INVALID -1
+#define JPEG_MODE_BASELINE 0
+#define JPEG_MODE_PROGRESSIVE 2
+
+/** A block of decoded pixels; for RGB8888, four bytes per pixel in R, G, B, A order. */
+typedef struct {
+  int x, y;
+  int iWidth, iHeight;
+  int iWidthUsed;
+  int iBpp;
+  uint16_t *pPixels;
+  void *pUser;
+} JPEGDRAW;
+
+typedef int (*JPEG_DRAW_CALLBACK)(JPEGDRAW *pDraw);
+
+class JPEGDEC {
+ public:
+  ~JPEGDEC() { this->close(); }
+
+  /** @return 1 if the header could be read, 0 otherwise. */
+  int openRAM(uint8_t *pData, int iDataSize, JPEG_DRAW_CALLBACK pfnDraw);
+  void close();
+  /** Decode the whole image at full size; the position and options are ignored. @return 1 on success. */
+  int decode(int x, int y, int iOptions);
+
+  int getWidth() { return this->width_; }
+  int getHeight() { return this->height_; }
+  int getBpp() { return this->bpp_; }
+  int getLastError() { return this->last_error_; }
+  int getJPEGType() { return this->type_; }
+  void setUserPointer(void *p) { this->user_ = p; }
+  void setPixelType(int iType) { this->pixel_type_ = iType; }
+
+ protected:
+  struct State;
+  State *state_{nullptr};
+  JPEG_DRAW_CALLBACK draw_{nullptr};
+  void *user_{nullptr};
+  int pixel_type_{RGB565_LITTLE_ENDIAN};
+  int width_{0};
+  int height_{0};
+  int bpp_{0};
+  int type_{JPEG_MODE_INVALID};
+  int last_error_{0};
+};
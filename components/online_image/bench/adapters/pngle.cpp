@@ -0,0 +1,107 @@
+// The pngle API used by the component, over the progressive reader of libpng.
+#include "pngle.h"
+
+#include <png.h>
+
+#include <csetjmp>
+#include <string>
+#include <vector>
+
+struct _pngle_t {
+  png_structp png{nullptr};
+  png_infop info{nullptr};
+  pngle_ihdr_t ihdr{};
+  void *user_data{nullptr};
+  pngle_init_callback_t init_callback{nullptr};
+  pngle_draw_callback_t draw_callback{nullptr};
+  /** The rows decoded so far, for interlaced images only. */
+  std::vector<uint8_t> rows;
+  std::string error;
+};
+
+static void error_callback(png_structp png, png_const_charp message) {
+  auto *pngle = static_cast<pngle_t *>(png_get_error_ptr(png));
+  pngle->error = message;
+  png_longjmp(png, 1);
+}
+
+static void warning_callback(png_structp png, png_const_charp message) {}
+
+static void info_callback(png_structp png, png_infop info) {
+  auto *pngle = static_cast<pngle_t *>(png_get_progressive_ptr(png));
+  pngle_ihdr_t &ihdr = pngle->ihdr;
+  ihdr.width = png_get_image_width(png, info);
+  ihdr.height = png_get_image_height(png, info);
+  ihdr.depth = png_get_bit_depth(png, info);
+  ihdr.color_type = png_get_color_type(png, info);
+  ihdr.compression = png_get_compression_type(png, info);
+  ihdr.filter = png_get_filter_type(png, info);
+  ihdr.interlace = png_get_interlace_type(png, info) != PNG_INTERLACE_NONE;
+
+  // Always 8-bit RGBA, as pngle draws it
+  png_set_expand(png);
+  png_set_strip_16(png);
+  png_set_gray_to_rgb(png);
+  png_set_add_alpha(png, 0xFF, PNG_FILLER_AFTER);
+  png_set_interlace_handling(png);
+  png_read_update_info(png, info);
+  if (ihdr.interlace) {
+    pngle->rows.assign(size_t(ihdr.width) * ihdr.height * 4, 0);
+  }
+  if (pngle->init_callback) {
+    pngle->init_callback(pngle, ihdr.width, ihdr.height);
+  }
+}
+
+static void row_callback(png_structp png, png_bytep row, png_uint_32 y, int pass) {
+  auto *pngle = static_cast<pngle_t *>(png_get_progressive_ptr(png));
+  if (!row || !pngle->draw_callback) {
+    return;
+  }
+  if (pngle->ihdr.interlace) {
+    // Every pass draws the row again, with the pixels known so far.
+    png_bytep combined = &pngle->rows[size_t(y) * pngle->ihdr.width * 4];
+    png_progressive_combine_row(png, combined, row);
+    row = combined;
+  }
+  for (uint32_t x = 0; x < pngle->ihdr.width; x++) {
+    pngle->draw_callback(pngle, x, y, 1, 1, row + x * 4);
+  }
+}
+
+pngle_t *pngle_new() {
+  auto *pngle = new pngle_t();
+  pngle->png = png_create_read_struct(PNG_LIBPNG_VER_STRING, pngle, error_callback, warning_callback);
+  pngle->info = pngle->png ? png_create_info_struct(pngle->png) : nullptr;
+  if (!pngle->info) {
+    pngle_destroy(pngle);
+    return nullptr;
+  }
+  png_set_progressive_read_fn(pngle->png, pngle, info_callback, row_callback, nullptr);
+  return pngle;
+}
+
+void pngle_destroy(pngle_t *pngle) {
+  if (pngle) {
+    png_destroy_read_struct(&pngle->png, pngle->info ? &pngle->info : nullptr, nullptr);
+    delete pngle;
+  }
+}
+
+int pngle_feed(pngle_t *pngle, const void *buf, size_t len) {
+  if (!pngle->error.empty()) {
+    return -1;
+  }
+  if (setjmp(png_jmpbuf(pngle->png))) {
+    return -1;
+  }
+  png_process_data(pngle->png, pngle->info, static_cast<png_bytep>(const_cast<void *>(buf)), len);
+  return static_cast<int>(len);
+}
+
+const char *pngle_error(pngle_t *pngle) { return pngle->error.c_str(); }
+pngle_ihdr_t *pngle_get_ihdr(pngle_t *pngle) { return &pngle->ihdr; }
+void pngle_set_user_data(pngle_t *pngle, void *user_data) { pngle->user_data = user_data; }
+void *pngle_get_user_data(pngle_t *pngle) { return pngle->user_data; }
+void pngle_set_init_callback(pngle_t *pngle, pngle_init_callback_t callback) { pngle->init_callback = callback; }
+void pngle_set_draw_callback(pngle_t *pngle, pngle_draw_callback_t callback) { pngle->draw_callback = callback; }
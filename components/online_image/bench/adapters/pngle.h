@@ -0,0 +1,34 @@
+// The pngle API used by the component, over the system libpng; see README.md.
+//
+// Only for building the benchmark without downloading pngle. Its times are those of libpng.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+typedef struct _pngle_t pngle_t;
+
+typedef struct {
+  uint32_t width;
+  uint32_t height;
+  uint8_t depth;
+  uint8_t color_type;
+  uint8_t compression;
+  uint8_t filter;
+  uint8_t interlace;
+} pngle_ihdr_t;
+
+typedef void (*pngle_init_callback_t)(pngle_t *pngle, uint32_t w, uint32_t h);
+typedef void (*pngle_draw_callback_t)(pngle_t *pngle, uint32_t x, uint32_t y, uint32_t w, uint32_t h,
+                                      uint8_t rgba[4]);
+
+pngle_t *pngle_new();
+void pngle_destroy(pngle_t *pngle);
+/** @return The number of bytes consumed, or -1 on error. */
+int pngle_feed(pngle_t *pngle, const void *buf, size_t len);
+const char *pngle_error(pngle_t *pngle);
+pngle_ihdr_t *pngle_get_ihdr(pngle_t *pngle);
+
+void pngle_set_user_data(pngle_t *pngle, void *user_data);
+void *pngle_get_user_data(pngle_t *pngle);
+void pngle_set_init_callback(pngle_t *pngle, pngle_init_callback_t callback);
+void pngle_set_draw_callback(pngle_t *pngle, pngle_draw_callback_t callback);
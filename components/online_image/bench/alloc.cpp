@@ -0,0 +1,83 @@
+// Counts the heap in use by wrapping the glibc allocator, so that every allocation is seen:
+// RAMAllocator, the standard library and the decoder libraries alike.
+#include "alloc.h"
+
+#include <malloc.h>
+
+#include <cstddef>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace {
+
+size_t in_use = 0;
+size_t peak = 0;
+
+void *count_allocation(void *ptr) {
+  if (ptr) {
+    in_use += malloc_usable_size(ptr);
+    if (in_use > peak) {
+      peak = in_use;
+    }
+  }
+  return ptr;
+}
+
+}  // namespace
+
+extern "C" {
+
+void *malloc(size_t size) { return count_allocation(__libc_malloc(size)); }
+
+void *calloc(size_t count, size_t size) { return count_allocation(__libc_calloc(count, size)); }
+
+void *realloc(void *ptr, size_t size) {
+  size_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+  void *result = __libc_realloc(ptr, size);
+  if (result || size == 0) {
+    in_use -= old_size;
+    count_allocation(result);
+  }
+  return result;
+}
+
+void *memalign(size_t alignment, size_t size) { return count_allocation(__libc_memalign(alignment, size)); }
+
+void *aligned_alloc(size_t alignment, size_t size) { return memalign(alignment, size); }
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+  void *result = memalign(alignment, size);
+  if (!result) {
+    return 12;  // ENOMEM
+  }
+  *ptr = result;
+  return 0;
+}
+
+void free(void *ptr) {
+  if (ptr) {
+    in_use -= malloc_usable_size(ptr);
+  }
+  __libc_free(ptr);
+}
+
+}  // extern "C"
+
+namespace bench {
+
+size_t heap_in_use() { return in_use; }
+
+size_t reset_heap_peak() {
+  peak = in_use;
+  return in_use;
+}
+
+size_t heap_peak() { return peak; }
+
+}  // namespace bench
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+namespace bench {
+
+/** Bytes allocated on the heap right now. */
+size_t heap_in_use();
+/** Start tracking the peak from the current use, which is returned. */
+size_t reset_heap_peak();
+/** Most bytes allocated at once since the last reset. */
+size_t heap_peak();
+
+}  // namespace bench
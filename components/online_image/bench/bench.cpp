@@ -0,0 +1,366 @@
+// Benchmark of the online_image decoders on the host; see README.md.
+//
+// The fixture files are served through a stub HTTP container in chunks of a configurable size,
+// so that the whole path of a download is measured: the download buffer, the decoder, the
+// resampler and the conversion to the storage format of the image buffer.
+#include "bench.h"
+
+#include "esphome/core/log.h"
+
+#include "alloc.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/** Loops of the component without the image being finished, after which a run is given up. */
+static const int MAX_LOOPS = 10000000;
+
+struct Options {
+  std::vector<size_t> chunks{512, 4096, 65536};
+  std::vector<image::ImageType> types{image::IMAGE_TYPE_BINARY, image::IMAGE_TYPE_GRAYSCALE,
+                                      image::IMAGE_TYPE_RGB565, image::IMAGE_TYPE_RGB};
+  image::Transparency transparency{image::TRANSPARENCY_OPAQUE};
+  ResizeFilter filter{RESIZE_FILTER_NEAREST};
+  int width{0};
+  int height{0};
+  uint32_t buffer_size{65536};
+  size_t max_buffer_size{512 * 1024};
+  int repeat{3};
+};
+
+int FixtureContainer::read(uint8_t *buf, size_t max_len) {
+  this->on_read_();
+  size_t len = std::min({max_len, this->chunk_, this->data_.size() - this->bytes_read_});
+  memcpy(buf, this->data_.data() + this->bytes_read_, len);
+  this->bytes_read_ += len;
+  return len;
+}
+
+bool load_fixture(const std::string &file, Fixture &fixture) {
+  std::ifstream stream(file, std::ios::binary);
+  if (!stream) {
+    fprintf(stderr, "Could not read %s\n", file.c_str());
+    return false;
+  }
+  fixture.name = file.substr(file.find_last_of('/') + 1);
+  fixture.data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  return true;
+}
+
+bool decode_fixture(BenchImage &image, const Fixture &fixture, size_t chunk) {
+  FixtureServer server;
+  server.serve(&fixture, chunk);
+  image.set_parent(&server);
+  bool done = false;
+  bool ok = false;
+  image.add_on_finished_callback([&]() {
+    done = true;
+    ok = true;
+  });
+  image.add_on_error_callback([&]() { done = true; });
+  image.update();
+  for (int i = 0; !done && i < MAX_LOOPS; i++) {
+    image.loop();
+  }
+  return ok;
+}
+
+bool decode_rgba(const Fixture &fixture, std::vector<uint8_t> &pixels, int &width, int &height, int &frames,
+                 size_t chunk) {
+  BenchImage image("http://bench/" + fixture.name, 0, 0, AUTO, image::IMAGE_TYPE_RGB,
+                   image::TRANSPARENCY_ALPHA_CHANNEL, 65536);
+  bool ok = decode_fixture(image, fixture, chunk);
+  if (ok) {
+    width = image.get_buffer_width();
+    height = image.get_buffer_height();
+    frames = image.get_buffer_frame_count();
+    pixels.assign(image.get_buffer(), image.get_buffer() + image.get_buffer_size());
+  }
+  image.release();
+  return ok;
+}
+
+struct Result {
+  bool ok{false};
+  uint32_t decode_us{0};
+  uint32_t pixels{0};
+  uint32_t pixels_drawn{0};
+  size_t bytes_copied{0};
+  size_t peak_heap{0};
+};
+
+static Result run(const Fixture &fixture, image::ImageType type, size_t chunk, const Options &options) {
+  Result result;
+  FixtureServer server;
+  size_t baseline = reset_heap_peak();
+  {
+    BenchImage image("http://bench/" + fixture.name, options.width, options.height, AUTO, type, options.transparency,
+                     options.buffer_size);
+    image.set_parent(&server);
+    image.set_resize_filter(options.filter);
+    image.set_max_download_buffer_size(options.max_buffer_size);
+    bool done = false;
+    image.add_on_finished_callback([&]() {
+      done = true;
+      result.ok = true;
+    });
+    image.add_on_error_callback([&]() { done = true; });
+    // Compaction happens just before the download buffer is filled, and the count is gone
+    // once the download is over.
+    auto sample = [&]() { result.bytes_copied = std::max(result.bytes_copied, image.get_bytes_copied()); };
+    server.serve(&fixture, chunk, sample);
+
+    image.update();
+    for (int i = 0; !done && i < MAX_LOOPS; i++) {
+      image.loop();
+    }
+    result.decode_us = image.get_decode_us();
+    result.pixels = image.get_buffer_pixels();
+    result.pixels_drawn = image.get_pixels_drawn();
+    image.release();
+  }
+  result.peak_heap = heap_peak() - baseline;
+  return result;
+}
+
+/** Whether the benchmark has been built with the decoder of a format, see CMakeLists.txt. */
+bool is_supported(const std::string &format) {
+#ifndef USE_ONLINE_IMAGE_PNG_SUPPORT
+  if (format == "PNG")
+    return false;
+#endif
+#ifndef USE_ONLINE_IMAGE_JPEG_SUPPORT
+  if (format == "JPEG")
+    return false;
+#endif
+#ifndef USE_ONLINE_IMAGE_WEBP_SUPPORT
+  if (format == "WebP")
+    return false;
+#endif
+  return format != "?";
+}
+
+const char *format_name(const std::vector<uint8_t> &data) {
+  auto starts_with = [&](const char *magic, size_t offset = 0) {
+    size_t len = strlen(magic);
+    return data.size() >= offset + len && memcmp(data.data() + offset, magic, len) == 0;
+  };
+  if (starts_with("\x89PNG"))
+    return "PNG";
+  if (starts_with("\xFF\xD8\xFF"))
+    return "JPEG";
+  if (starts_with("RIFF") && starts_with("WEBP", 8))
+    return "WebP";
+  if (starts_with("BM"))
+    return "BMP";
+  if (starts_with("qoif"))
+    return "QOI";
+  if (starts_with("GIF8"))
+    return "GIF";
+  return "?";
+}
+
+const char *type_name(image::ImageType type) {
+  switch (type) {
+    case image::IMAGE_TYPE_BINARY:
+      return "binary";
+    case image::IMAGE_TYPE_GRAYSCALE:
+      return "grayscale";
+    case image::IMAGE_TYPE_RGB565:
+      return "rgb565";
+    case image::IMAGE_TYPE_RGB:
+      return "rgb";
+  }
+  return "?";
+}
+
+static std::vector<std::string> split(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    items.push_back(item);
+  }
+  return items;
+}
+
+bool parse_types(const std::string &list, std::vector<image::ImageType> &types) {
+  types.clear();
+  for (auto &item : split(list)) {
+    if (item == "binary") {
+      types.push_back(image::IMAGE_TYPE_BINARY);
+    } else if (item == "grayscale") {
+      types.push_back(image::IMAGE_TYPE_GRAYSCALE);
+    } else if (item == "rgb565") {
+      types.push_back(image::IMAGE_TYPE_RGB565);
+    } else if (item == "rgb") {
+      types.push_back(image::IMAGE_TYPE_RGB);
+    } else {
+      return false;
+    }
+  }
+  return !types.empty();
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [decode] [options] FILE...\n"
+          "       %s resample [options] FILE...    comparison of the resize filters\n"
+          "       %s frames [options] FILE...      compressed storage of animations\n"
+          "       %s check [options] MANIFEST      pixels of the fixtures\n"
+          "\n"
+          "Decoding, for every file, image type and chunk size:\n"
+          "  --chunk N[,N...]     bytes returned per read of the download (default: 512,4096,65536)\n"
+          "  --type T[,T...]      binary, grayscale, rgb565, rgb (default: all)\n"
+          "  --transparency T     opaque, chroma_key, alpha_channel (default: opaque)\n"
+          "  --size WxH           size of the image buffer, to measure resizing (default: as decoded)\n"
+          "  --filter F           nearest or smooth resizing (default: nearest)\n"
+          "  --buffer N           initial download buffer size (default: 65536)\n"
+          "  --max-buffer N       maximum download buffer size (default: 524288)\n"
+          "  --repeat N           runs per combination; the fastest one is reported (default: 3)\n"
+          "  --log N              log level of the component, 0-5 (default: 2, warnings)\n",
+          program, program, program, program);
+}
+
+static bool parse_options(int argc, char **argv, Options &options, std::vector<std::string> &files) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) {
+      files.push_back(arg);
+      continue;
+    }
+    if (i + 1 >= argc) {
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--chunk") {
+      options.chunks.clear();
+      for (auto &item : split(value)) {
+        options.chunks.push_back(std::stoul(item));
+      }
+    } else if (arg == "--type") {
+      if (!parse_types(value, options.types)) {
+        return false;
+      }
+    } else if (arg == "--transparency") {
+      if (value == "opaque") {
+        options.transparency = image::TRANSPARENCY_OPAQUE;
+      } else if (value == "chroma_key") {
+        options.transparency = image::TRANSPARENCY_CHROMA_KEY;
+      } else if (value == "alpha_channel") {
+        options.transparency = image::TRANSPARENCY_ALPHA_CHANNEL;
+      } else {
+        return false;
+      }
+    } else if (arg == "--size") {
+      if (sscanf(value.c_str(), "%dx%d", &options.width, &options.height) != 2) {
+        return false;
+      }
+    } else if (arg == "--filter") {
+      if (value == "nearest") {
+        options.filter = RESIZE_FILTER_NEAREST;
+      } else if (value == "smooth") {
+        options.filter = RESIZE_FILTER_SMOOTH;
+      } else {
+        return false;
+      }
+    } else if (arg == "--buffer") {
+      options.buffer_size = std::stoul(value);
+    } else if (arg == "--max-buffer") {
+      options.max_buffer_size = std::stoul(value);
+    } else if (arg == "--repeat") {
+      options.repeat = std::max(1, std::stoi(value));
+    } else if (arg == "--log") {
+      bench_log_level = std::stoi(value);
+    } else {
+      return false;
+    }
+  }
+  return !files.empty() && !options.chunks.empty() && !options.types.empty();
+}
+
+static int decode_main(int argc, char **argv) {
+  Options options;
+  std::vector<std::string> files;
+  if (!parse_options(argc, argv, options, files)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<Fixture> fixtures(files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    if (!load_fixture(files[i], fixtures[i])) {
+      return 1;
+    }
+  }
+
+  printf("%-24s %-5s %-9s %7s %8s %10s %10s %10s %12s %9s\n", "file", "fmt", "type", "chunk", "MB/s", "Mpixels/s",
+         "peak KiB", "memmove", "px writes", "per pixel");
+  int failures = 0;
+  for (auto &fixture : fixtures) {
+    if (!is_supported(format_name(fixture.data))) {
+      printf("%-24s %-5s not supported by this build\n", fixture.name.c_str(), format_name(fixture.data));
+      continue;
+    }
+    for (auto type : options.types) {
+      for (auto chunk : options.chunks) {
+        Result best;
+        for (int i = 0; i < options.repeat; i++) {
+          Result result = run(fixture, type, chunk, options);
+          if (!result.ok) {
+            best = result;
+            break;
+          }
+          if (!best.ok || result.decode_us < best.decode_us) {
+            best = result;
+          }
+        }
+        if (!best.ok) {
+          printf("%-24s %-5s %-9s %7zu  failed to decode\n", fixture.name.c_str(), format_name(fixture.data),
+                 type_name(type), chunk);
+          failures++;
+          continue;
+        }
+        // Bytes per microsecond are MB/s, pixels per microsecond Mpixels/s.
+        double us = std::max<uint32_t>(best.decode_us, 1);
+        printf("%-24s %-5s %-9s %7zu %8.2f %10.2f %10.1f %10zu %12" PRIu32 " %9.2f\n", fixture.name.c_str(),
+               format_name(fixture.data), type_name(type), chunk, fixture.data.size() / us, best.pixels / us,
+               best.peak_heap / 1024.0, best.bytes_copied, best.pixels_drawn,
+               best.pixels ? double(best.pixels_drawn) / best.pixels : 0.0);
+      }
+    }
+  }
+  return failures ? 1 : 0;
+}
+
+static int main(int argc, char **argv) {
+  std::string command = argc > 1 ? argv[1] : "";
+  if (command != "decode" && command != "resample" && command != "frames" && command != "check") {
+    return decode_main(argc, argv);
+  }
+  // The commands see the program name in place of their own.
+  argv[1] = argv[0];
+  if (command == "resample") {
+    return resample_main(argc - 1, argv + 1);
+  }
+  if (command == "frames") {
+    return frames_main(argc - 1, argv + 1);
+  }
+  if (command == "check") {
+    return check_main(argc - 1, argv + 1);
+  }
+  return decode_main(argc - 1, argv + 1);
+}
+
+}  // namespace bench
+
+int main(int argc, char **argv) { return bench::main(argc, argv); }
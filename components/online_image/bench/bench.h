@@ -0,0 +1,112 @@
+// Parts of the host benchmark shared by its commands; see README.md.
+#pragma once
+
+#include "online_image.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+using namespace esphome;
+using namespace esphome::online_image;
+
+struct Fixture {
+  std::string name;
+  std::vector<uint8_t> data;
+};
+
+/** Read a file into a fixture, named after the file; false if it cannot be read. */
+bool load_fixture(const std::string &file, Fixture &fixture);
+
+/** Serves a fixture file in pieces of at most `chunk` bytes per read. */
+class FixtureContainer : public http_request::HttpContainer {
+ public:
+  FixtureContainer(const std::vector<uint8_t> &data, size_t chunk, std::function<void()> on_read)
+      : data_(data), chunk_(chunk), on_read_(std::move(on_read)) {
+    this->status_code = 200;
+    this->content_length = data.size();
+  }
+
+  int read(uint8_t *buf, size_t max_len) override;
+  void end() override {}
+
+ protected:
+  const std::vector<uint8_t> &data_;
+  size_t chunk_;
+  std::function<void()> on_read_;
+};
+
+class FixtureServer : public http_request::HttpRequestComponent {
+ public:
+  void serve(const Fixture *fixture, size_t chunk, std::function<void()> on_read = [] {}) {
+    this->fixture_ = fixture;
+    this->chunk_ = chunk;
+    this->on_read_ = std::move(on_read);
+  }
+
+  std::shared_ptr<http_request::HttpContainer> get(const std::string &url,
+                                                   const std::list<http_request::Header> &request_headers,
+                                                   const std::set<std::string> &collect_headers) override {
+    return std::make_shared<FixtureContainer>(this->fixture_->data, this->chunk_, this->on_read_);
+  }
+
+ protected:
+  const Fixture *fixture_{nullptr};
+  size_t chunk_{0};
+  std::function<void()> on_read_;
+};
+
+/** Gives access to the statistics the component collects for its log, and to its image buffer. */
+class BenchImage : public OnlineImage {
+ public:
+  using OnlineImage::OnlineImage;
+
+  uint32_t get_decode_us() const { return this->decode_us_; }
+  uint32_t get_pixels_drawn() const { return this->pixels_drawn_; }
+  size_t get_bytes_copied() const { return this->download_buffer_.get_bytes_copied(); }
+  uint32_t get_buffer_pixels() const {
+    return uint32_t(this->buffer_width_) * this->buffer_height_ * this->buffer_frame_count_;
+  }
+  int get_buffer_width() const { return this->buffer_width_; }
+  int get_buffer_height() const { return this->buffer_height_; }
+  int get_buffer_frame_count() const { return this->buffer_frame_count_; }
+  int get_buffer_frame_size() const { return this->buffer_frame_size_; }
+  /** The image buffer; all frames, unless they are compressed or decoded on demand. */
+  const uint8_t *get_buffer() const { return this->buffer_; }
+  size_t get_buffer_size() const { return this->get_buffer_size_(); }
+
+  /** Allocate the buffer for a decoded image of the given size, as the decoders do. */
+  bool allocate(int width, int height, int frames = 1) { return this->resize_(width, height, frames) > 0; }
+  void draw_pixel(int x, int y, Color color, int frame = 0) { this->draw_pixel_(x, y, color, frame); }
+};
+
+/**
+ * @brief Download and decode a fixture at its own size.
+ *
+ * @param image An image with no fixed size; set up further as needed.
+ * @return false if the fixture could not be decoded.
+ */
+bool decode_fixture(BenchImage &image, const Fixture &fixture, size_t chunk = 65536);
+
+/** Decode a fixture into RGBA pixels, all frames one after the other. */
+bool decode_rgba(const Fixture &fixture, std::vector<uint8_t> &pixels, int &width, int &height, int &frames,
+                 size_t chunk = 65536);
+
+/** Name of the format of a file, from its first bytes. */
+const char *format_name(const std::vector<uint8_t> &data);
+/** Whether this build has the decoder of a format, by its name. */
+bool is_supported(const std::string &format);
+const char *type_name(image::ImageType type);
+/** Parse a comma-separated list of image types; false if one is unknown. */
+bool parse_types(const std::string &list, std::vector<image::ImageType> &types);
+
+/** Comparison of the resize filters; see resample_bench.cpp. */
+int resample_main(int argc, char **argv);
+/** Compressed storage of animations; see frame_store_bench.cpp. */
+int frames_main(int argc, char **argv);
+/** Pixels of the fixtures against their manifest; see check.cpp. */
+int check_main(int argc, char **argv);
+
+}  // namespace bench
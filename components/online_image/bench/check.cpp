@@ -0,0 +1,189 @@
+// Check of the decoded pixels of the fixtures on the host; see README.md.
+//
+// make_fixtures.py lists what every fixture must decode to in a manifest: a CRC-32 of the
+// RGBA pixels of all frames for lossless files, a minimum PSNR against another fixture for
+// lossy ones, or a failure for files the component does not support. Every file is decoded
+// at its own size into an RGBA image buffer, in pieces of the given sizes.
+#include "bench.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace bench {
+
+static uint32_t crc32(const std::vector<uint8_t> &data) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (uint8_t byte : data) {
+    crc ^= byte;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+/** @return The PSNR, in dB, of the RGB channels of two RGBA images of the same size. */
+static double psnr(const std::vector<uint8_t> &pixels, const std::vector<uint8_t> &reference) {
+  double error = 0;
+  for (size_t i = 0; i < pixels.size(); i += 4) {
+    for (int c = 0; c < 3; c++) {
+      double difference = pixels[i + c] - reference[i + c];
+      error += difference * difference;
+    }
+  }
+  double mse = error / (pixels.size() / 4 * 3);
+  return mse == 0 ? INFINITY : 10 * std::log10(255.0 * 255.0 / mse);
+}
+
+struct Expected {
+  std::string file;
+  int width{0};
+  int height{0};
+  int frames{0};
+  /** "crc32", "psnr" or "error". */
+  std::string check;
+  uint32_t crc{0};
+  double min_psnr{0};
+  std::string reference;
+};
+
+static bool parse_line(const std::string &line, const std::string &directory, Expected &expected) {
+  std::istringstream stream(line);
+  std::string width;
+  stream >> expected.file >> width;
+  expected.file = directory + expected.file;
+  if (width == "error") {
+    expected.check = width;
+    return true;
+  }
+  expected.width = atoi(width.c_str());
+  stream >> expected.height >> expected.frames >> expected.check;
+  if (expected.check == "crc32") {
+    stream >> std::hex >> expected.crc;
+  } else if (expected.check == "psnr") {
+    stream >> expected.min_psnr >> expected.reference;
+    expected.reference = directory + expected.reference;
+  } else {
+    return false;
+  }
+  return !stream.fail();
+}
+
+/** @return An empty string if the file decodes as expected, otherwise what is wrong. */
+static std::string check(const Expected &expected, const Fixture &fixture, size_t chunk) {
+  std::vector<uint8_t> pixels;
+  int width, height, frames;
+  bool ok = decode_rgba(fixture, pixels, width, height, frames, chunk);
+  if (expected.check == "error") {
+    return ok ? "decoded, but should fail" : "";
+  }
+  if (!ok) {
+    return "failed to decode";
+  }
+  if (width != expected.width || height != expected.height || frames != expected.frames) {
+    return "decoded to " + std::to_string(width) + "x" + std::to_string(height) + ", " + std::to_string(frames) +
+           " frames";
+  }
+  char text[64];
+  if (expected.check == "crc32") {
+    uint32_t crc = crc32(pixels);
+    if (crc != expected.crc) {
+      snprintf(text, sizeof(text), "CRC-32 %08x, expected %08x", crc, expected.crc);
+      return text;
+    }
+    return "";
+  }
+  Fixture reference;
+  std::vector<uint8_t> reference_pixels;
+  if (!load_fixture(expected.reference, reference) ||
+      !decode_rgba(reference, reference_pixels, width, height, frames) || reference_pixels.size() != pixels.size()) {
+    return "reference " + expected.reference + " could not be decoded";
+  }
+  double db = psnr(pixels, reference_pixels);
+  if (db < expected.min_psnr) {
+    snprintf(text, sizeof(text), "PSNR %.2f dB, expected at least %.2f dB", db, expected.min_psnr);
+    return text;
+  }
+  return "";
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s check [options] MANIFEST\n"
+          "  --chunk N[,N...]     bytes served per read (default: 1024,65536)\n",
+          program);
+}
+
+int check_main(int argc, char **argv) {
+  std::vector<size_t> chunks{1024, 65536};
+  std::string manifest;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0 && manifest.empty()) {
+      manifest = arg;
+    } else if (arg == "--chunk" && i + 1 < argc) {
+      chunks.clear();
+      std::stringstream stream(argv[++i]);
+      std::string item;
+      while (std::getline(stream, item, ',')) {
+        chunks.push_back(std::max<size_t>(1, std::stoul(item)));
+      }
+    } else {
+      manifest.clear();
+      break;
+    }
+  }
+  std::ifstream input(manifest);
+  if (manifest.empty() || chunks.empty() || !input) {
+    usage(argv[0]);
+    return 2;
+  }
+  // Paths are relative to the manifest.
+  size_t slash = manifest.rfind('/');
+  std::string directory = slash == std::string::npos ? "" : manifest.substr(0, slash + 1);
+
+  printf("%-24s %-5s %7s  %s\n", "file", "fmt", "chunk", "pixels");
+  int failures = 0;
+  int checked = 0;
+  std::string line;
+  while (std::getline(input, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    Expected expected;
+    Fixture fixture;
+    if (!parse_line(line, directory, expected)) {
+      printf("invalid line: %s\n", line.c_str());
+      failures++;
+      continue;
+    }
+    if (!load_fixture(expected.file, fixture)) {
+      printf("%-24s could not be read\n", expected.file.c_str());
+      failures++;
+      continue;
+    }
+    const char *format = format_name(fixture.data);
+    if (!is_supported(format)) {
+      printf("%-24s %-5s not supported by this build\n", fixture.name.c_str(), format);
+      continue;
+    }
+    for (size_t chunk : chunks) {
+      std::string error = check(expected, fixture, chunk);
+      printf("%-24s %-5s %7zu  %s\n", fixture.name.c_str(), format, chunk,
+             error.empty() ? (expected.check == "error" ? "refused, as expected" : "ok") : error.c_str());
+      checked++;
+      if (!error.empty()) {
+        failures++;
+      }
+    }
+  }
+  if (checked == 0) {
+    printf("nothing checked\n");
+    return 1;
+  }
+  return failures ? 1 : 0;
+}
+
+}  // namespace bench
@@ -0,0 +1,69 @@
+// The parts of the esphome core the component uses, for running it on the host.
+#include "esphome/components/display/display.h"
+#include "esphome/core/application.h"
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace esphome {
+
+Application App;  // NOLINT
+
+namespace setup_priority {
+const float LATE = -100.0f;
+}  // namespace setup_priority
+
+namespace display {
+const Color COLOR_OFF(0, 0, 0, 0);
+const Color COLOR_ON(255, 255, 255, 255);
+}  // namespace display
+
+static const auto START = std::chrono::steady_clock::now();
+
+uint32_t millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - START).count();
+}
+
+uint32_t micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - START).count();
+}
+
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+std::string str_sprintf(const char *fmt, ...) {
+  std::string str;
+  va_list args;
+  va_start(args, fmt);
+  int length = vsnprintf(nullptr, 0, fmt, args);
+  va_end(args);
+  if (length > 0) {
+    str.resize(length + 1);
+    va_start(args, fmt);
+    vsnprintf(&str[0], length + 1, fmt, args);
+    va_end(args);
+    str.resize(length);
+  }
+  return str;
+}
+
+int bench_log_level = BENCH_LOG_WARN;
+
+void bench_log(int level, const char *tag, const char *format, ...) {
+  static const char LEVELS[] = "?EWIDV";
+  if (level > bench_log_level) {
+    return;
+  }
+  fprintf(stderr, "[%c][%s] ", LEVELS[level], tag);
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  fputc('\n', stderr);
+}
+
+}  // namespace esphome
@@ -0,0 +1,157 @@
+// Compressed storage of animations on the host; see README.md.
+//
+// Every file is decoded with all its frames in the buffer; the frames are then encoded into a
+// FrameStore, and restored once in order, which applies a single delta per frame, and once in a
+// random order, which replays the deltas from the keyframe. Every restored frame is compared
+// against the decoded one.
+#include "bench.h"
+#include "frame_store.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace bench {
+
+struct Result {
+  bool ok{false};
+  int frames{0};
+  size_t frame_size{0};
+  size_t stored{0};
+  double sequential_us{0};
+  double random_us{0};
+};
+
+/**
+ * @brief Restore the frames in the given order into a working frame, and check each of them.
+ *
+ * Restoring the keyframe is a plain copy, and is not timed.
+ *
+ * @return The time per restore in microseconds, or a negative value if a frame differs.
+ */
+static double restore(const FrameStore &store, const uint8_t *frames, size_t frame_size,
+                      const std::vector<int> &order) {
+  std::vector<uint8_t> working(frames, frames + frame_size);
+  int current = 0;
+  double us = 0;
+  size_t timed = 0;
+  for (int frame : order) {
+    auto start = std::chrono::steady_clock::now();
+    store.restore(working.data(), current, frame);
+    if (frame != 0) {
+      us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      timed++;
+    }
+    current = frame;
+    if (memcmp(working.data(), frames + frame_size * frame, frame_size) != 0) {
+      return -1;
+    }
+  }
+  return us / std::max<size_t>(timed, 1);
+}
+
+static Result run(const Fixture &fixture, image::ImageType type, int repeat) {
+  Result result;
+  BenchImage image("http://bench/" + fixture.name, 0, 0, AUTO, type, image::TRANSPARENCY_OPAQUE, 65536);
+  if (!decode_fixture(image, fixture) || image.get_buffer_frame_count() < 2) {
+    image.release();
+    return result;
+  }
+  result.frames = image.get_buffer_frame_count();
+  result.frame_size = image.get_buffer_frame_size();
+  const uint8_t *frames = image.get_buffer();
+
+  FrameStore store;
+  if (store.encode(frames, result.frame_size, result.frames)) {
+    // The component also keeps the working frame allocated.
+    result.stored = store.size() + result.frame_size;
+
+    std::vector<int> sequential;
+    for (int i = 0; i < repeat; i++) {
+      for (int frame = 1; frame < result.frames; frame++) {
+        sequential.push_back(frame);
+      }
+      // Back to the first frame, as the animation loops
+      sequential.push_back(0);
+    }
+    // Never the same or the next frame, so every restore starts from the keyframe
+    std::vector<int> random;
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<int> distribution(0, result.frames - 1);
+    int current = 0;
+    while (random.size() < sequential.size()) {
+      int frame = distribution(generator);
+      if (frame != current && frame != current + 1) {
+        random.push_back(frame);
+        current = frame;
+      }
+    }
+
+    result.sequential_us = restore(store, frames, result.frame_size, sequential);
+    result.random_us = restore(store, frames, result.frame_size, random);
+    result.ok = result.sequential_us >= 0 && result.random_us >= 0;
+  }
+  image.release();
+  return result;
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s frames [options] FILE...\n"
+          "  --type T[,T...]      binary, grayscale, rgb565, rgb (default: all)\n"
+          "  --repeat N           times every frame is restored in each order (default: 100)\n",
+          program);
+}
+
+int frames_main(int argc, char **argv) {
+  std::vector<image::ImageType> types{image::IMAGE_TYPE_BINARY, image::IMAGE_TYPE_GRAYSCALE,
+                                      image::IMAGE_TYPE_RGB565, image::IMAGE_TYPE_RGB};
+  int repeat = 100;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) {
+      files.push_back(arg);
+    } else if (arg == "--type" && i + 1 < argc && parse_types(argv[++i], types)) {
+      continue;
+    } else if (arg == "--repeat" && i + 1 < argc) {
+      repeat = std::max(1, std::stoi(argv[++i]));
+    } else {
+      files.clear();
+      break;
+    }
+  }
+  if (files.empty()) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  printf("%-24s %-10s %6s %10s %10s %6s %13s %13s\n", "file", "type", "frames", "raw KiB", "stored KiB", "ratio",
+         "sequential us", "random us");
+  int failures = 0;
+  for (auto &file : files) {
+    Fixture fixture;
+    if (!load_fixture(file, fixture)) {
+      printf("%-24s could not be read\n", file.c_str());
+      failures++;
+      continue;
+    }
+    for (auto type : types) {
+      Result result = run(fixture, type, repeat);
+      if (!result.ok) {
+        printf("%-24s %-10s not an animation, or a restored frame differs\n", fixture.name.c_str(),
+               type_name(type));
+        failures++;
+        continue;
+      }
+      size_t raw = result.frame_size * result.frames;
+      printf("%-24s %-10s %6d %10.1f %10.1f %6.2f %13.2f %13.2f\n", fixture.name.c_str(), type_name(type),
+             result.frames, raw / 1024.0, result.stored / 1024.0, static_cast<double>(result.stored) / raw,
+             result.sequential_us, result.random_us);
+    }
+  }
+  return failures ? 1 : 0;
+}
+
+}  // namespace bench
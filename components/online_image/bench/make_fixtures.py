@@ -0,0 +1,340 @@
+#!/usr/bin/env python3
+"""Generate the fixture images of the online_image benchmark.
+
+BMP, QOI, GIF and PNG files are written with the standard library only. JPEG and WebP
+files are added if Pillow is installed; any other file can be passed to the benchmark too.
+
+With --manifest, the pixels each fixture must decode to are listed for `online_image_bench check`.
+"""
+
+import argparse
+import math
+import os
+import random
+import struct
+import zlib
+
+
+def make_pixels(width, height, seed=1):
+    """A photo-like picture: smooth gradients, a few shapes and some noise."""
+    rng = random.Random(seed)
+    pixels = []
+    for y in range(height):
+        for x in range(width):
+            r = int(127 + 127 * math.sin(x / 23.0 + y / 57.0))
+            g = int(127 + 127 * math.sin(y / 19.0 - x / 71.0))
+            b = (x * 255 // max(1, width - 1) + y * 255 // max(1, height - 1)) // 2
+            if (x - width // 3) ** 2 + (y - height // 2) ** 2 < (height // 4) ** 2:
+                r, g, b = 255 - r, 255 - g, 255 - b
+            noise = rng.randint(-6, 6)
+            pixels.append(tuple(max(0, min(255, c + noise)) for c in (r, g, b)))
+    return pixels
+
+
+def make_zone_plate(width, height):
+    """Rings of increasing frequency, which alias visibly when an image is shrunk without filtering."""
+    pixels = []
+    scale = math.pi / (2 * max(width, height))
+    for y in range(height):
+        for x in range(width):
+            dx, dy = x - width / 2, y - height / 2
+            v = int(127.5 + 127.5 * math.cos((dx * dx + dy * dy) * scale))
+            pixels.append((v, v, v))
+    return pixels
+
+
+def quantize(pixels, levels=(6, 7, 6)):
+    """Map to a 252 color palette, for the indexed formats."""
+    palette = []
+    for r in range(levels[0]):
+        for g in range(levels[1]):
+            for b in range(levels[2]):
+                palette.append(
+                    (r * 255 // (levels[0] - 1), g * 255 // (levels[1] - 1), b * 255 // (levels[2] - 1))
+                )
+    indices = []
+    for r, g, b in pixels:
+        ri = r * (levels[0] - 1) // 255
+        gi = g * (levels[1] - 1) // 255
+        bi = b * (levels[2] - 1) // 255
+        indices.append((ri * levels[1] + gi) * levels[2] + bi)
+    return palette, indices
+
+
+def write_bmp24(path, width, height, pixels):
+    row_size = (width * 3 + 3) & ~3
+    data = bytearray()
+    for y in reversed(range(height)):
+        row = bytearray()
+        for x in range(width):
+            r, g, b = pixels[y * width + x]
+            row += bytes((b, g, r))
+        data += row + bytes(row_size - len(row))
+    header = struct.pack("<2sIHHI", b"BM", 54 + len(data), 0, 0, 54)
+    info = struct.pack("<IiiHHIIiiII", 40, width, height, 1, 24, 0, len(data), 2835, 2835, 0, 0)
+    with open(path, "wb") as f:
+        f.write(header + info + data)
+
+
+def write_bmp8(path, width, height, palette, indices, rle=False):
+    if rle:
+        data = bytearray()
+        for y in reversed(range(height)):
+            row = indices[y * width : (y + 1) * width]
+            x = 0
+            while x < width:
+                run = 1
+                while x + run < width and run < 255 and row[x + run] == row[x]:
+                    run += 1
+                data += bytes((run, row[x]))
+                x += run
+            data += b"\x00\x00"
+        data += b"\x00\x01"
+        compression = 1
+    else:
+        row_size = (width + 3) & ~3
+        data = bytearray()
+        for y in reversed(range(height)):
+            row = bytes(indices[y * width : (y + 1) * width])
+            data += row + bytes(row_size - len(row))
+        compression = 0
+    colors = b"".join(bytes((b, g, r, 0)) for r, g, b in palette) + bytes(4 * (256 - len(palette)))
+    offset = 54 + len(colors)
+    header = struct.pack("<2sIHHI", b"BM", offset + len(data), 0, 0, offset)
+    info = struct.pack("<IiiHHIIiiII", 40, width, height, 1, 8, compression, len(data), 2835, 2835, 256, 0)
+    with open(path, "wb") as f:
+        f.write(header + info + colors + data)
+
+
+def write_qoi(path, width, height, pixels):
+    out = bytearray(b"qoif" + struct.pack(">IIBB", width, height, 3, 0))
+    index = [(0, 0, 0, 0)] * 64
+    prev = (0, 0, 0, 255)
+    run = 0
+    for r, g, b in pixels:
+        px = (r, g, b, 255)
+        if px == prev:
+            run += 1
+            if run == 62:
+                out.append(0xC0 | (run - 1))
+                run = 0
+            continue
+        if run:
+            out.append(0xC0 | (run - 1))
+            run = 0
+        h = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64
+        if index[h] == px:
+            out.append(h)
+        else:
+            index[h] = px
+            dr, dg, db = (r - prev[0] + 128) % 256 - 128, (g - prev[1] + 128) % 256 - 128, (b - prev[2] + 128) % 256 - 128
+            if -2 <= dr <= 1 and -2 <= dg <= 1 and -2 <= db <= 1:
+                out.append(0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2))
+            elif -32 <= dg <= 31 and -8 <= dr - dg <= 7 and -8 <= db - dg <= 7:
+                out += bytes((0x80 | (dg + 32), ((dr - dg + 8) << 4) | (db - dg + 8)))
+            else:
+                out += bytes((0xFE, r, g, b))
+        prev = px
+    if run:
+        out.append(0xC0 | (run - 1))
+    out += bytes(7) + b"\x01"
+    with open(path, "wb") as f:
+        f.write(out)
+
+
+def write_png(path, width, height, pixels):
+    raw = bytearray()
+    for y in range(height):
+        raw.append(0)
+        for x in range(width):
+            raw += bytes(pixels[y * width + x])
+
+    def chunk(kind, data):
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data))
+
+    png = b"\x89PNG\r\n\x1a\n"
+    png += chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0))
+    png += chunk(b"IDAT", zlib.compress(bytes(raw), 6))
+    png += chunk(b"IEND", b"")
+    with open(path, "wb") as f:
+        f.write(png)
+
+
+def lzw_encode(indices, min_code_size):
+    clear = 1 << min_code_size
+    end = clear + 1
+    out = bytearray()
+    bits = 0
+    bit_count = 0
+
+    def emit(code, size):
+        nonlocal bits, bit_count
+        bits |= code << bit_count
+        bit_count += size
+        while bit_count >= 8:
+            out.append(bits & 0xFF)
+            bits >>= 8
+            bit_count -= 8
+
+    size = min_code_size + 1
+    table = {bytes([i]): i for i in range(clear)}
+    next_code = end + 1
+    emit(clear, size)
+    string = b""
+    for index in indices:
+        extended = string + bytes([index])
+        if extended in table:
+            string = extended
+            continue
+        emit(table[string], size)
+        if next_code < 4096:
+            table[extended] = next_code
+            next_code += 1
+            if next_code > (1 << size) and size < 12:
+                size += 1
+        else:
+            emit(clear, size)
+            size = min_code_size + 1
+            table = {bytes([i]): i for i in range(clear)}
+            next_code = end + 1
+        string = bytes([index])
+    if string:
+        emit(table[string], size)
+    emit(end, size)
+    if bit_count:
+        out.append(bits & 0xFF)
+    blocks = bytearray([min_code_size])
+    for i in range(0, len(out), 255):
+        block = out[i : i + 255]
+        blocks += bytes([len(block)]) + block
+    return bytes(blocks) + b"\x00"
+
+
+def write_gif(path, width, height, palette, frames):
+    """frames: list of (x, y, width, height, indices); all frames last 100 ms."""
+    colors = b"".join(bytes(c) for c in palette) + bytes(3 * (256 - len(palette)))
+    gif = bytearray(b"GIF89a" + struct.pack("<HHBBB", width, height, 0xF7, 0, 0) + colors)
+    if len(frames) > 1:
+        gif += b"\x21\xFF\x0BNETSCAPE2.0\x03\x01\x00\x00\x00"
+    for x, y, w, h, indices in frames:
+        gif += b"\x21\xF9\x04" + bytes((1 << 2,)) + struct.pack("<H", 10) + b"\x00\x00"
+        gif += b"\x2C" + struct.pack("<HHHHB", x, y, w, h, 0)
+        gif += lzw_encode(indices, 8)
+    gif += b"\x3B"
+    with open(path, "wb") as f:
+        f.write(gif)
+
+
+class Manifest:
+    """What each fixture decodes to, as RGBA pixels of all frames one after the other.
+
+    Lines are `FILE WIDTH HEIGHT FRAMES crc32 CRC` for exact pixels,
+    `FILE WIDTH HEIGHT FRAMES psnr MIN_DB REFERENCE` for lossy files, compared on RGB with
+    another fixture, and `FILE error` for files the component must refuse. Paths are relative
+    to the manifest.
+    """
+
+    def __init__(self, path, directory):
+        self.path = path
+        self.directory = os.path.relpath(directory, os.path.dirname(os.path.abspath(path)))
+        self.lines = []
+
+    def exact(self, name, width, height, frames):
+        """frames: list of frames, each a list of (r, g, b) pixels."""
+        rgba = bytearray()
+        for pixels in frames:
+            for r, g, b in pixels:
+                rgba += bytes((r, g, b, 255))
+        self.lines.append(f"{self.file(name)} {width} {height} {len(frames)} crc32 {zlib.crc32(rgba):08x}")
+
+    def lossy(self, name, width, height, min_psnr, reference):
+        self.lines.append(f"{self.file(name)} {width} {height} 1 psnr {min_psnr} {self.file(reference)}")
+
+    def error(self, name):
+        self.lines.append(f"{self.file(name)} error")
+
+    def file(self, name):
+        return os.path.join(self.directory, name)
+
+    def write(self):
+        with open(self.path, "w") as f:
+            f.write("# Written by make_fixtures.py; see the Manifest class.\n")
+            f.write("\n".join(self.lines) + "\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("directory", help="where to write the fixtures")
+    parser.add_argument("--size", default="320x240", help="size of the images (default: 320x240)")
+    parser.add_argument("--frames", type=int, default=8, help="frames of the animated GIF (default: 8)")
+    parser.add_argument("--manifest", help="where to list the pixels of each fixture")
+    args = parser.parse_args()
+    width, height = (int(v) for v in args.size.split("x"))
+
+    os.makedirs(args.directory, exist_ok=True)
+    path = lambda name: os.path.join(args.directory, name)
+    manifest = Manifest(args.manifest or os.devnull, args.directory)
+    pixels = make_pixels(width, height)
+    palette, indices = quantize(pixels)
+    indexed = [palette[i] for i in indices]
+    zone_plate = make_zone_plate(width, height)
+
+    write_bmp24(path("photo_24bit.bmp"), width, height, pixels)
+    manifest.exact("photo_24bit.bmp", width, height, [pixels])
+    write_bmp8(path("photo_8bit.bmp"), width, height, palette, indices)
+    manifest.exact("photo_8bit.bmp", width, height, [indexed])
+    # Posterized, so that runs are long enough to be worth encoding
+    _, flat = quantize(pixels, (2, 3, 2))
+    write_bmp8(path("flat_rle8.bmp"), width, height, palette, flat, rle=True)
+    manifest.exact("flat_rle8.bmp", width, height, [[palette[i] for i in flat]])
+    write_qoi(path("photo.qoi"), width, height, pixels)
+    manifest.exact("photo.qoi", width, height, [pixels])
+    write_qoi(path("zone_plate.qoi"), width, height, zone_plate)
+    manifest.exact("zone_plate.qoi", width, height, [zone_plate])
+    write_png(path("photo.png"), width, height, pixels)
+    manifest.exact("photo.png", width, height, [pixels])
+    write_gif(path("photo.gif"), width, height, palette, [(0, 0, width, height, indices)])
+    manifest.exact("photo.gif", width, height, [indexed])
+
+    # An animation in which a box moves over the picture, redrawing only what changes
+    frames = [(0, 0, width, height, indices)]
+    box = max(8, min(width, height) // 4)
+    for i in range(1, args.frames):
+        x = (i * (width - box)) // max(1, args.frames - 1)
+        y = (height - box) // 2
+        patch = [(indices[(y + j) * width + x + k] + 17 * i) % len(palette) for j in range(box) for k in range(box)]
+        frames.append((x, y, box, box, patch))
+    write_gif(path("animation.gif"), width, height, palette, frames)
+    # Each frame is drawn over the previous one.
+    composed = []
+    screen = list(indices)
+    for x, y, w, h, patch in frames:
+        for j in range(h):
+            screen[(y + j) * width + x : (y + j) * width + x + w] = patch[j * w : (j + 1) * w]
+        composed.append([palette[i] for i in screen])
+    manifest.exact("animation.gif", width, height, composed)
+
+    try:
+        from PIL import Image
+    except ImportError:
+        print("Pillow is not installed; no JPEG and WebP fixtures")
+    else:
+        picture = Image.new("RGB", (width, height))
+        picture.putdata(pixels)
+        picture.save(path("photo.jpg"), quality=85)
+        # Refused by the component; kept apart from the files to benchmark
+        os.makedirs(path("refused"), exist_ok=True)
+        picture.save(path("refused/photo_progressive.jpg"), quality=85, progressive=True)
+        picture.save(path("photo.webp"), quality=85)
+        picture.save(path("photo_lossless.webp"), lossless=True)
+        manifest.lossy("photo.jpg", width, height, 28, "photo.qoi")
+        manifest.error("refused/photo_progressive.jpg")
+        manifest.lossy("photo.webp", width, height, 28, "photo.qoi")
+        manifest.exact("photo_lossless.webp", width, height, [pixels])
+
+    if args.manifest:
+        manifest.write()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,243 @@
+// Comparison of the resize filters on the host; see README.md.
+//
+// Every file is decoded once; its pixels are then pushed through each resize path in raster
+// order, as the decoders do, into an RGBA image buffer. Quality is the PSNR of the result
+// against a reference computed in double precision: the exact area average when shrinking,
+// bilinear interpolation at pixel centres when enlarging.
+#include "bench.h"
+#include "resampler.h"
+
+#include "esphome/core/log.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+namespace bench {
+
+/** Resizing as it was done before the Resampler, with double scale factors; the baseline. */
+class DoubleNearest {
+ public:
+  DoubleNearest(BenchImage *image, int src_width, int src_height)
+      : image_(image),
+        x_scale_(static_cast<double>(image->get_buffer_width()) / src_width),
+        y_scale_(static_cast<double>(image->get_buffer_height()) / src_height) {}
+
+  void draw(int x, int y, int w, int h, const Color &color) {
+    auto width = std::min(this->image_->get_buffer_width(), static_cast<int>(std::ceil((x + w) * this->x_scale_)));
+    auto height = std::min(this->image_->get_buffer_height(), static_cast<int>(std::ceil((y + h) * this->y_scale_)));
+    for (int i = x * this->x_scale_; i < width; i++) {
+      for (int j = y * this->y_scale_; j < height; j++) {
+        this->image_->draw_pixel(i, j, color);
+      }
+    }
+  }
+
+ protected:
+  BenchImage *image_;
+  double x_scale_;
+  double y_scale_;
+};
+
+enum Path {
+  PATH_DOUBLE_NEAREST,
+  PATH_NEAREST,
+  PATH_SMOOTH,
+};
+
+static const char *const PATH_NAMES[] = {"double nearest", "nearest", "smooth"};
+
+struct Source {
+  std::string name;
+  int width;
+  int height;
+  std::vector<uint8_t> rgba;
+};
+
+/** Source pixels and weights contributing to each destination pixel along one axis. */
+struct Taps {
+  std::vector<std::vector<std::pair<int, double>>> taps;
+};
+
+static Taps make_taps(int src, int dst) {
+  Taps result;
+  result.taps.resize(dst);
+  double scale = static_cast<double>(src) / dst;
+  for (int i = 0; i < dst; i++) {
+    auto &taps = result.taps[i];
+    if (dst <= src) {
+      // Area covered by the destination pixel
+      double start = i * scale;
+      double end = (i + 1) * scale;
+      for (int s = static_cast<int>(start); s < src && s < end; s++) {
+        double weight = std::min<double>(end, s + 1) - std::max<double>(start, s);
+        if (weight > 0) {
+          taps.emplace_back(s, weight / scale);
+        }
+      }
+    } else {
+      // Bilinear at pixel centres, clamped at the edges
+      double center = std::max(0.0, (i + 0.5) * scale - 0.5);
+      int s0 = std::min(static_cast<int>(center), src - 1);
+      int s1 = std::min(s0 + 1, src - 1);
+      double fraction = center - s0;
+      taps.emplace_back(s0, 1 - fraction);
+      taps.emplace_back(s1, fraction);
+    }
+  }
+  return result;
+}
+
+/** Reference resize, RGB in double precision. */
+static std::vector<double> reference(const Source &source, int width, int height) {
+  Taps x_taps = make_taps(source.width, width);
+  Taps y_taps = make_taps(source.height, height);
+  // Columns first, then rows
+  std::vector<double> columns(size_t(source.height) * width * 3);
+  for (int y = 0; y < source.height; y++) {
+    for (int i = 0; i < width; i++) {
+      for (auto &tap : x_taps.taps[i]) {
+        const uint8_t *p = &source.rgba[(size_t(y) * source.width + tap.first) * 4];
+        for (int c = 0; c < 3; c++) {
+          columns[(size_t(y) * width + i) * 3 + c] += p[c] * tap.second;
+        }
+      }
+    }
+  }
+  std::vector<double> result(size_t(height) * width * 3);
+  for (int j = 0; j < height; j++) {
+    for (auto &tap : y_taps.taps[j]) {
+      for (size_t k = 0; k < size_t(width) * 3; k++) {
+        result[size_t(j) * width * 3 + k] += columns[size_t(tap.first) * width * 3 + k] * tap.second;
+      }
+    }
+  }
+  return result;
+}
+
+/** @return The PSNR, in dB, of the RGB channels of an RGBA image buffer against the reference. */
+static double psnr(const BenchImage &image, const std::vector<double> &expected) {
+  const uint8_t *buffer = image.get_buffer();
+  size_t pixels = size_t(image.get_buffer_width()) * image.get_buffer_height();
+  double error = 0;
+  for (size_t i = 0; i < pixels; i++) {
+    for (int c = 0; c < 3; c++) {
+      double difference = buffer[i * 4 + c] - expected[i * 3 + c];
+      error += difference * difference;
+    }
+  }
+  double mse = error / (pixels * 3);
+  return mse == 0 ? INFINITY : 10 * std::log10(255.0 * 255.0 / mse);
+}
+
+struct Result {
+  double us{0};
+  double psnr{0};
+};
+
+static Result run(const Source &source, int width, int height, Path path) {
+  Result result;
+  BenchImage image("http://bench/" + source.name, width, height, AUTO, image::IMAGE_TYPE_RGB,
+                   image::TRANSPARENCY_ALPHA_CHANNEL, 0);
+  if (!image.allocate(source.width, source.height)) {
+    image.release();
+    return result;
+  }
+  DoubleNearest double_nearest(&image, source.width, source.height);
+  Resampler resampler(&image);
+  resampler.set_size(source.width, source.height, width, height,
+                     path == PATH_SMOOTH ? RESIZE_FILTER_SMOOTH : RESIZE_FILTER_NEAREST);
+
+  auto start = std::chrono::steady_clock::now();
+  const uint8_t *p = source.rgba.data();
+  for (int y = 0; y < source.height; y++) {
+    for (int x = 0; x < source.width; x++, p += 4) {
+      Color color(p[0], p[1], p[2], p[3]);
+      if (path == PATH_DOUBLE_NEAREST) {
+        double_nearest.draw(x, y, 1, 1, color);
+      } else {
+        resampler.draw(x, y, 1, 1, color, 0);
+      }
+    }
+  }
+  result.us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  result.psnr = psnr(image, reference(source, width, height));
+  image.release();
+  return result;
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s resample [options] FILE...\n"
+          "  --scale F[,F...]     sizes of the image buffer, relative to the decoded image\n"
+          "                       (default: 0.5,0.3,0.1,1.5)\n"
+          "  --repeat N           runs per combination; the fastest one is reported (default: 3)\n",
+          program);
+}
+
+int resample_main(int argc, char **argv) {
+  std::vector<double> scales{0.5, 0.3, 0.1, 1.5};
+  int repeat = 3;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) {
+      files.push_back(arg);
+    } else if (arg == "--scale" && i + 1 < argc) {
+      scales.clear();
+      std::stringstream stream(argv[++i]);
+      std::string item;
+      while (std::getline(stream, item, ',')) {
+        scales.push_back(std::stod(item));
+      }
+    } else if (arg == "--repeat" && i + 1 < argc) {
+      repeat = std::max(1, std::stoi(argv[++i]));
+    } else {
+      files.clear();
+      break;
+    }
+  }
+  if (files.empty() || scales.empty()) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  printf("%-24s %-9s %-9s %-15s %10s %9s\n", "file", "from", "to", "filter", "Mpixels/s", "PSNR dB");
+  int failures = 0;
+  for (auto &file : files) {
+    Fixture fixture;
+    Source source;
+    int frames;
+    if (!load_fixture(file, fixture) || !decode_rgba(fixture, source.rgba, source.width, source.height, frames)) {
+      printf("%-24s could not be decoded\n", fixture.name.c_str());
+      failures++;
+      continue;
+    }
+    source.name = fixture.name;
+    // Only the first frame of an animation is resized.
+    source.rgba.resize(size_t(source.width) * source.height * 4);
+    std::string from = std::to_string(source.width) + "x" + std::to_string(source.height);
+
+    for (double scale : scales) {
+      int width = std::max(1, static_cast<int>(std::lround(source.width * scale)));
+      int height = std::max(1, static_cast<int>(std::lround(source.height * scale)));
+      std::string to = std::to_string(width) + "x" + std::to_string(height);
+      for (Path path : {PATH_DOUBLE_NEAREST, PATH_NEAREST, PATH_SMOOTH}) {
+        Result best;
+        for (int i = 0; i < repeat; i++) {
+          Result result = run(source, width, height, path);
+          if (i == 0 || result.us < best.us) {
+            best = result;
+          }
+        }
+        // Source pixels per microsecond are Mpixels/s.
+        printf("%-24s %-9s %-9s %-15s %10.2f %9.2f\n", source.name.c_str(), from.c_str(), to.c_str(),
+               PATH_NAMES[path], source.width * source.height / std::max(best.us, 1.0), best.psnr);
+      }
+    }
+  }
+  return failures ? 1 : 0;
+}
+
+}  // namespace bench
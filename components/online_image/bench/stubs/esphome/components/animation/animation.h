@@ -0,0 +1,45 @@
+#pragma once
+#include "esphome/components/image/image.h"
+#include "esphome/core/automation.h"
+
+namespace esphome {
+namespace animation {
+
+class Animation : public image::Image {
+ public:
+  Animation(const uint8_t *data_start, int width, int height, uint32_t animation_frame_count, image::ImageType type,
+            image::Transparency transparent)
+      : Image(data_start, width, height, type, transparent),
+        animation_data_start_(data_start),
+        animation_frame_count_(animation_frame_count) {}
+
+  uint32_t get_animation_frame_count() const { return this->animation_frame_count_; }
+  int get_current_frame() const { return this->current_frame_; }
+  void next_frame() { this->set_frame(this->current_frame_ + 1); }
+  void prev_frame() { this->set_frame(this->current_frame_ - 1); }
+  void set_frame(int frame) {
+    if (this->animation_frame_count_ == 0) {
+      return;
+    }
+    this->current_frame_ = (frame % int(this->animation_frame_count_) + this->animation_frame_count_) %
+                           this->animation_frame_count_;
+    this->update_data_start_();
+  }
+  void set_loop(uint32_t start_frame, uint32_t end_frame, int count) {}
+
+ protected:
+  virtual void update_data_start_() {
+    this->data_start_ = this->animation_data_start_ + this->current_frame_ * this->get_width_stride() * this->height_;
+  }
+
+  const uint8_t *animation_data_start_;
+  int current_frame_{0};
+  uint32_t animation_frame_count_;
+  uint32_t loop_start_frame_{0};
+  uint32_t loop_end_frame_{0};
+  int loop_count_{0};
+  int loop_current_iteration_{1};
+};
+
+}  // namespace animation
+}  // namespace esphome
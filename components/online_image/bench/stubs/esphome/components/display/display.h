@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+
+#include "esphome/core/color.h"
+
+namespace esphome {
+namespace display {
+
+enum ColorOrder : uint8_t { COLOR_ORDER_RGB = 0, COLOR_ORDER_BGR = 1, COLOR_ORDER_GRB = 2 };
+enum ColorBitness : uint8_t { COLOR_BITNESS_888 = 0, COLOR_BITNESS_565 = 1, COLOR_BITNESS_332 = 2 };
+
+extern const Color COLOR_OFF;
+extern const Color COLOR_ON;
+
+struct Rect {
+  int16_t x{0}, y{0}, w{0}, h{0};
+  bool is_set() const { return this->w > 0 && this->h > 0; }
+  int16_t x2() const { return this->x + this->w; }
+  int16_t y2() const { return this->y + this->h; }
+};
+
+class ColorUtil {
+ public:
+  static uint16_t color_to_565(Color color, ColorOrder color_order = ColorOrder::COLOR_ORDER_RGB) {
+    return ((color.r >> 3) << 11) | ((color.g >> 2) << 5) | (color.b >> 3);
+  }
+};
+
+/** Nothing is drawn on the host; the benchmark only decodes into the image buffer. */
+class Display {
+ public:
+  virtual ~Display() = default;
+  virtual void draw_pixel_at(int x, int y, Color color) {}
+  virtual void draw_pixels_at(int x_start, int y_start, int w, int h, const uint8_t *ptr, ColorOrder order,
+                              ColorBitness bitness, bool big_endian, int x_offset, int y_offset, int x_pad) {}
+  void draw_pixels_at(int x_start, int y_start, int w, int h, const uint8_t *ptr, ColorOrder order,
+                      ColorBitness bitness, bool big_endian) {
+    this->draw_pixels_at(x_start, y_start, w, h, ptr, order, bitness, big_endian, 0, 0, 0);
+  }
+  virtual int get_width() { return 0; }
+  virtual int get_height() { return 0; }
+  Rect get_clipping() const { return Rect(); }
+  bool is_clipping() const { return false; }
+};
+
+class BaseImage {
+ public:
+  virtual ~BaseImage() = default;
+  virtual void draw(int x, int y, Display *display, Color color_on, Color color_off) = 0;
+  virtual int get_width() const = 0;
+  virtual int get_height() const = 0;
+};
+
+}  // namespace display
+}  // namespace esphome
@@ -0,0 +1,2 @@
+#pragma once
+#include "esphome/components/display/display.h"
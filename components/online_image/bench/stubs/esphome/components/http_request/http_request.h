@@ -0,0 +1,51 @@
+#pragma once
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace http_request {
+
+struct Header {
+  std::string name;
+  std::string value;
+};
+
+class HttpRequestComponent;
+
+class HttpContainer : public Parented<HttpRequestComponent> {
+ public:
+  virtual ~HttpContainer() = default;
+  size_t content_length{0};
+  int status_code{-1};
+  uint32_t duration_ms{0};
+
+  virtual int read(uint8_t *buf, size_t max_len) = 0;
+  virtual void end() = 0;
+
+  size_t get_bytes_read() const { return this->bytes_read_; }
+  std::string get_response_header(const std::string &header_name) {
+    auto it = this->response_headers_.find(header_name);
+    return it == this->response_headers_.end() ? "" : it->second;
+  }
+
+ protected:
+  size_t bytes_read_{0};
+  std::map<std::string, std::string> response_headers_;
+};
+
+/** Implemented by the benchmark, serving fixture files instead of doing requests. */
+class HttpRequestComponent : public Component {
+ public:
+  virtual std::shared_ptr<HttpContainer> get(const std::string &url, const std::list<Header> &request_headers,
+                                             const std::set<std::string> &collect_headers) = 0;
+};
+
+}  // namespace http_request
+}  // namespace esphome
@@ -0,0 +1,54 @@
+#pragma once
+#include "esphome/components/display/display.h"
+
+namespace esphome {
+namespace image {
+
+enum ImageType {
+  IMAGE_TYPE_BINARY = 0,
+  IMAGE_TYPE_GRAYSCALE = 1,
+  IMAGE_TYPE_RGB = 2,
+  IMAGE_TYPE_RGB565 = 3,
+};
+
+enum Transparency {
+  TRANSPARENCY_OPAQUE = 0,
+  TRANSPARENCY_CHROMA_KEY = 1,
+  TRANSPARENCY_ALPHA_CHANNEL = 2,
+};
+
+class Image : public display::BaseImage {
+ public:
+  Image(const uint8_t *data_start, int width, int height, ImageType type, Transparency transparency)
+      : width_(width), height_(height), type_(type), data_start_(data_start), transparency_(transparency) {}
+  int get_width() const override { return this->width_; }
+  int get_height() const override { return this->height_; }
+  const uint8_t *get_data_start() const { return this->data_start_; }
+  ImageType get_type() const { return this->type_; }
+  int get_bpp() const {
+    switch (this->type_) {
+      case IMAGE_TYPE_BINARY:
+        return 1;
+      case IMAGE_TYPE_GRAYSCALE:
+        return 8;
+      case IMAGE_TYPE_RGB565:
+        return this->transparency_ == TRANSPARENCY_ALPHA_CHANNEL ? 24 : 16;
+      case IMAGE_TYPE_RGB:
+        return this->transparency_ == TRANSPARENCY_ALPHA_CHANNEL ? 32 : 24;
+    }
+    return 0;
+  }
+  size_t get_width_stride() const { return (this->width_ * this->get_bpp() + 7u) / 8u; }
+  void draw(int x, int y, display::Display *display, Color color_on, Color color_off) override {}
+  bool has_transparency() const { return this->transparency_ != TRANSPARENCY_OPAQUE; }
+
+ protected:
+  int width_;
+  int height_;
+  ImageType type_;
+  const uint8_t *data_start_;
+  Transparency transparency_;
+};
+
+}  // namespace image
+}  // namespace esphome
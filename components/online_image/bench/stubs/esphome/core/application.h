@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+
+namespace esphome {
+
+class Application {
+ public:
+  void feed_wdt(uint32_t time = 0) {}
+};
+
+extern Application App;
+
+}  // namespace esphome
@@ -0,0 +1,24 @@
+#pragma once
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+template<typename... Ts> class Trigger {
+ public:
+  void trigger(const Ts &...x) {}
+};
+
+template<typename... Ts> class Action {
+ public:
+  virtual ~Action() = default;
+  virtual void play(const Ts &...x) = 0;
+};
+
+}  // namespace esphome
+
+#define TEMPLATABLE_VALUE(type, name) \
+ protected: \
+  std::function<type(Ts...)> name##_{}; \
+\
+ public: \
+  template<typename V> void set_##name(V name) {}
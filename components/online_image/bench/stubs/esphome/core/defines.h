@@ -0,0 +1,2 @@
+#pragma once
+// The USE_ONLINE_IMAGE_* defines are set by CMakeLists.txt, depending on the enabled formats.
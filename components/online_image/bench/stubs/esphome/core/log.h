@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdarg>
+
+namespace esphome {
+
+enum BenchLogLevel { BENCH_LOG_ERROR = 1, BENCH_LOG_WARN, BENCH_LOG_INFO, BENCH_LOG_DEBUG, BENCH_LOG_VERBOSE };
+
+/** Messages above this level are dropped; set with --log. */
+extern int bench_log_level;
+
+void bench_log(int level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+}  // namespace esphome
+
+#define ESP_LOGE(tag, ...) esphome::bench_log(esphome::BENCH_LOG_ERROR, tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) esphome::bench_log(esphome::BENCH_LOG_WARN, tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) esphome::bench_log(esphome::BENCH_LOG_INFO, tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) esphome::bench_log(esphome::BENCH_LOG_DEBUG, tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) esphome::bench_log(esphome::BENCH_LOG_VERBOSE, tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) esphome::bench_log(esphome::BENCH_LOG_INFO, tag, __VA_ARGS__)
@@ -6,42 +6,127 @@
 #include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 
+#include "online_image.h"
+
+#include <algorithm>
+#include <cinttypes>
+
 namespace esphome {
 namespace online_image {
 
 static const char *const TAG = "online_image.bmp";
 
+/** BITMAPFILEHEADER, in front of the DIB header. */
+static const size_t FILE_HEADER_SIZE = 14;
+static const size_t CORE_HEADER_SIZE = 12;
+static const size_t INFO_HEADER_SIZE = 40;
+static const size_t MAX_HEADER_SIZE = 124;
+/** Largest RLE opcode: an absolute run of 255 pixels at 8 bpp, padded to 16 bits. */
+static const size_t MAX_RLE_OPCODE_SIZE = 2 + 256;
+/** Pixels of a row converted at once, on the stack. */
+static const int ROW_CHUNK = 32;
+
+static inline uint16_t read_le16(const uint8_t *p) { return encode_uint16(p[1], p[0]); }
+static inline uint32_t read_le32(const uint8_t *p) { return encode_uint32(p[3], p[2], p[1], p[0]); }
+
+void BmpDecoder::ChannelMask::set(uint32_t mask) {
+  this->mask = mask;
+  this->shift = mask ? __builtin_ctz(mask) : 0;
+  this->max = mask >> this->shift;
+}
+
 int HOT BmpDecoder::decode(uint8_t *buffer, size_t size) {
   size_t index = 0;
-  if (this->current_index_ == 0 && index == 0 && size > 14) {
-    /**
-     * BMP file format:
-     * 0-1: Signature (BM)
-     * 2-5: File size
-     * 6-9: Reserved
-     * 10-13: Pixel data offset
-     *
-     * Integer values are stored in little-endian format.
-     */
-
-    // Check if the file is a BMP image
-    if (buffer[0] != 'B' || buffer[1] != 'M') {
-      ESP_LOGE(TAG, "Not a BMP file");
-      return DECODE_ERROR_INVALID_TYPE;
+  while (true) {
+    const uint8_t *data = buffer + index;
+    size_t available = size - index;
+    State state = this->state_;
+    size_t consumed = 0;
+    switch (state) {
+      case STATE_HEADER: {
+        int header_size = this->parse_header_(data, available);
+        if (header_size < 0) {
+          return header_size;
+        }
+        if (header_size > 0) {
+          // The download buffer may have been resized for the pixel data; continue on the next call.
+          this->position_ += header_size;
+          this->decoded_bytes_ += header_size;
+          return header_size;
+        }
+        break;
+      }
+      case STATE_PALETTE:
+        consumed = this->read_palette_(data, available);
+        break;
+      case STATE_GAP:
+        consumed = this->skip_gap_(available);
+        break;
+      case STATE_PIXELS:
+        if (this->compression_ == COMPRESSION_RLE8 || this->compression_ == COMPRESSION_RLE4) {
+          consumed = this->decode_rle_(data, available);
+        } else {
+          consumed = this->decode_rows_(data, available);
+        }
+        break;
+      case STATE_TRAILER:
+        consumed = available;
+        break;
     }
+    index += consumed;
+    this->position_ += consumed;
+    if (consumed == 0 && state == this->state_) {
+      break;
+    }
+  }
+  this->decoded_bytes_ += index;
+  return index;
+}
 
-    this->download_size_ = encode_uint32(buffer[5], buffer[4], buffer[3], buffer[2]);
-    this->data_offset_ = encode_uint32(buffer[13], buffer[12], buffer[11], buffer[10]);
-
-    this->current_index_ = 14;
-    index = 14;
+int BmpDecoder::parse_header_(const uint8_t *data, size_t size) {
+  /**
+   * BMP file format:
+   * 0-1: Signature (BM)
+   * 2-5: File size
+   * 6-9: Reserved
+   * 10-13: Pixel data offset
+   * 14-17: DIB header size
+   *
+   * Integer values are stored in little-endian format.
+   */
+  if (size < FILE_HEADER_SIZE + 4) {
+    return 0;
+  }
+  if (data[0] != 'B' || data[1] != 'M') {
+    ESP_LOGE(TAG, "Not a BMP file");
+    return DECODE_ERROR_INVALID_TYPE;
   }
-  if (this->current_index_ == 14 && index == 14 && size > this->data_offset_) {
+  this->data_offset_ = read_le32(data + 10);
+  uint32_t dib_size = read_le32(data + 14);
+  size_t header_size = FILE_HEADER_SIZE + dib_size;
+  uint32_t colors_used = 0;
+
+  if (dib_size == CORE_HEADER_SIZE) {
+    /**
+     * OS/2 BITMAPCOREHEADER:
+     * 18-19: Image width
+     * 20-21: Image height
+     * 22-23: Number of color planes
+     * 24-25: Bits per pixel
+     */
+    if (size < header_size) {
+      return 0;
+    }
+    this->width_ = read_le16(data + 18);
+    this->height_ = static_cast<int16_t>(read_le16(data + 20));
+    this->bits_per_pixel_ = read_le16(data + 24);
+    this->compression_ = COMPRESSION_RGB;
+    this->palette_entry_size_ = 3;
+  } else if (dib_size >= INFO_HEADER_SIZE && dib_size <= MAX_HEADER_SIZE) {
     /**
-     * BMP DIB header:
-     * 14-17: DIB header size
+     * BITMAPINFOHEADER, and its later versions:
      * 18-21: Image width
-     * 22-25: Image height
+     * 22-25: Image height (negative for top-down images)
      * 26-27: Number of color planes
      * 28-29: Bits per pixel
      * 30-33: Compression method
@@ -49,51 +134,317 @@ int HOT BmpDecoder::decode(uint8_t *buffer, size_t size) {
      * 38-41: Horizontal resolution
      * 42-45: Vertical resolution
      * 46-49: Number of colors in the color table
+     * 50-53: Number of important colors
+     * 54-65: Red, green and blue masks (version 2+, or following a plain BITMAPINFOHEADER)
+     * 66-69: Alpha mask (version 3+, or following a plain BITMAPINFOHEADER)
      */
+    if (size < FILE_HEADER_SIZE + INFO_HEADER_SIZE) {
+      return 0;
+    }
+    this->width_ = static_cast<int32_t>(read_le32(data + 18));
+    this->height_ = static_cast<int32_t>(read_le32(data + 22));
+    this->bits_per_pixel_ = read_le16(data + 28);
+    this->compression_ = read_le32(data + 30);
+    colors_used = read_le32(data + 46);
 
-    this->width_ = encode_uint32(buffer[21], buffer[20], buffer[19], buffer[18]);
-    this->height_ = encode_uint32(buffer[25], buffer[24], buffer[23], buffer[22]);
-    this->bits_per_pixel_ = encode_uint16(buffer[29], buffer[28]);
-    this->compression_method_ = encode_uint32(buffer[33], buffer[32], buffer[31], buffer[30]);
-    this->image_data_size_ = encode_uint32(buffer[37], buffer[36], buffer[35], buffer[34]);
-    this->color_table_entries_ = encode_uint32(buffer[49], buffer[48], buffer[47], buffer[46]);
-
-    switch (this->bits_per_pixel_) {
-      case 1:
-        this->width_bytes_ = (this->width_ % 8 == 0) ? (this->width_ / 8) : (this->width_ / 8 + 1);
-        break;
-      default:
-        ESP_LOGE(TAG, "Unsupported bits per pixel: %d", this->bits_per_pixel_);
-        return DECODE_ERROR_UNSUPPORTED_FORMAT;
+    bool bitfields = this->compression_ == COMPRESSION_BITFIELDS || this->compression_ == COMPRESSION_ALPHABITFIELDS;
+    if (bitfields && dib_size == INFO_HEADER_SIZE) {
+      header_size += this->compression_ == COMPRESSION_ALPHABITFIELDS ? 16 : 12;
+    }
+    if (size < header_size) {
+      return 0;
     }
+    if (bitfields) {
+      this->red_.set(read_le32(data + 54));
+      this->green_.set(read_le32(data + 58));
+      this->blue_.set(read_le32(data + 62));
+      if (header_size >= FILE_HEADER_SIZE + 56) {
+        this->alpha_.set(read_le32(data + 66));
+      }
+    }
+  } else {
+    ESP_LOGE(TAG, "Unsupported DIB header size: %" PRIu32, dib_size);
+    return DECODE_ERROR_UNSUPPORTED_FORMAT;
+  }
+
+  this->top_down_ = this->height_ < 0;
+  if (this->top_down_) {
+    this->height_ = -this->height_;
+  }
+  if (this->width_ <= 0 || this->height_ == 0) {
+    ESP_LOGE(TAG, "Invalid image size: %dx%d", this->width_, this->height_);
+    return DECODE_ERROR_INVALID_TYPE;
+  }
+
+  bool supported;
+  switch (this->compression_) {
+    case COMPRESSION_RGB:
+      supported = true;
+      break;
+    case COMPRESSION_RLE8:
+      supported = this->bits_per_pixel_ == 8 && !this->top_down_;
+      break;
+    case COMPRESSION_RLE4:
+      supported = this->bits_per_pixel_ == 4 && !this->top_down_;
+      break;
+    case COMPRESSION_BITFIELDS:
+    case COMPRESSION_ALPHABITFIELDS:
+      supported = this->bits_per_pixel_ == 16 || this->bits_per_pixel_ == 32;
+      break;
+    default:
+      supported = false;
+  }
+  if (!supported) {
+    ESP_LOGE(TAG, "Unsupported compression method %" PRIu32 " for %u bits per pixel", this->compression_,
+             static_cast<unsigned>(this->bits_per_pixel_));
+    return DECODE_ERROR_UNSUPPORTED_FORMAT;
+  }
 
-    if (this->compression_method_ != 0) {
-      ESP_LOGE(TAG, "Unsupported compression method: %d", this->compression_method_);
+  switch (this->bits_per_pixel_) {
+    case 1:
+    case 4:
+    case 8: {
+      // Start with a gray ramp, in case the color table is missing or incomplete.
+      size_t max_entries = 1u << this->bits_per_pixel_;
+      this->palette_.resize(max_entries);
+      for (size_t i = 0; i < max_entries; i++) {
+        uint8_t gray = i * 255 / (max_entries - 1);
+        this->palette_[i] = Color(gray, gray, gray);
+      }
+      this->palette_entries_ = colors_used ? std::min<size_t>(colors_used, max_entries) : max_entries;
+      size_t table_size = this->data_offset_ > header_size ? this->data_offset_ - header_size : 0;
+      this->palette_entries_ = std::min(this->palette_entries_, table_size / this->palette_entry_size_);
+      break;
+    }
+    case 16:
+      if (this->compression_ == COMPRESSION_RGB) {
+        // 5 bits per channel
+        this->red_.set(0x7C00);
+        this->green_.set(0x03E0);
+        this->blue_.set(0x001F);
+      }
+      break;
+    case 24:
+      break;
+    case 32:
+      if (this->compression_ == COMPRESSION_RGB) {
+        // The fourth byte is unused.
+        this->red_.set(0x00FF0000);
+        this->green_.set(0x0000FF00);
+        this->blue_.set(0x000000FF);
+      }
+      break;
+    default:
+      ESP_LOGE(TAG, "Unsupported bits per pixel: %u", static_cast<unsigned>(this->bits_per_pixel_));
       return DECODE_ERROR_UNSUPPORTED_FORMAT;
+  }
+  if (this->data_offset_ < header_size) {
+    ESP_LOGE(TAG, "Pixel data offset %zu inside the headers", this->data_offset_);
+    return DECODE_ERROR_INVALID_TYPE;
+  }
+
+  this->row_bytes_ = (this->width_ * this->bits_per_pixel_ + 31u) / 32u * 4u;
+  ESP_LOGD(TAG, "BMP %dx%d, %u bpp, compression %" PRIu32 ", %s", this->width_, this->height_,
+           static_cast<unsigned>(this->bits_per_pixel_), this->compression_, this->top_down_ ? "top-down" : "bottom-up");
+
+  if (!this->set_size(this->width_, this->height_)) {
+    return DECODE_ERROR_OUT_OF_MEMORY;
+  }
+  // Rows and RLE opcodes are only decoded once complete, so they must fit in the download buffer.
+  bool rle = this->compression_ == COMPRESSION_RLE8 || this->compression_ == COMPRESSION_RLE4;
+  size_t needed = rle ? MAX_RLE_OPCODE_SIZE : this->row_bytes_;
+  if (this->image_->resize_download_buffer(needed) == 0) {
+    return DECODE_ERROR_OUT_OF_MEMORY;
+  }
+  this->state_ = STATE_PALETTE;
+  return header_size;
+}
+
+size_t BmpDecoder::read_palette_(const uint8_t *data, size_t size) {
+  size_t consumed = 0;
+  while (this->palette_read_ < this->palette_entries_ && size - consumed >= this->palette_entry_size_) {
+    const uint8_t *entry = data + consumed;
+    this->palette_[this->palette_read_++] = Color(entry[2], entry[1], entry[0]);
+    consumed += this->palette_entry_size_;
+  }
+  if (this->palette_read_ == this->palette_entries_) {
+    this->state_ = STATE_GAP;
+  }
+  return consumed;
+}
+
+size_t BmpDecoder::skip_gap_(size_t size) {
+  size_t gap = std::min(size, this->data_offset_ - this->position_);
+  if (this->position_ + gap == this->data_offset_) {
+    this->state_ = STATE_PIXELS;
+  }
+  return gap;
+}
+
+size_t BmpDecoder::decode_rows_(const uint8_t *data, size_t size) {
+  size_t consumed = 0;
+  while (size - consumed >= this->row_bytes_ && this->current_row_ < this->height_) {
+    this->decode_row_(data + consumed, this->current_y_());
+    consumed += this->row_bytes_;
+    this->current_row_++;
+  }
+  if (this->current_row_ == this->height_) {
+    this->state_ = STATE_TRAILER;
+  }
+  return consumed;
+}
+
+void HOT BmpDecoder::decode_row_(const uint8_t *row, int y) {
+  Color colors[ROW_CHUNK];
+  // Unscaled rows are converted straight into the image buffer; otherwise the pixels go
+  // through the resampler.
+  const bool direct = this->can_store_pixels();
+  for (int x = 0; x < this->width_; x += ROW_CHUNK) {
+    int count = std::min(ROW_CHUNK, this->width_ - x);
+    this->convert_pixels_(row, x, count, colors);
+    if (direct) {
+      this->store_pixels(x, y, colors, count);
+      continue;
+    }
+    for (int i = 0; i < count; i++) {
+      this->draw(x + i, y, 1, 1, colors[i]);
     }
+  }
+}
+
+void BmpDecoder::convert_pixels_(const uint8_t *row, int x, int count, Color *colors) const {
+  const int end = x + count;
+  switch (this->bits_per_pixel_) {
+    case 1:
+      for (; x < end; x++) {
+        *colors++ = this->palette_[(row[x >> 3] >> (7 - (x & 7))) & 0x01];
+      }
+      break;
+    case 4:
+      for (; x < end; x++) {
+        *colors++ = this->palette_[(row[x >> 1] >> ((x & 1) ? 0 : 4)) & 0x0F];
+      }
+      break;
+    case 8:
+      for (; x < end; x++) {
+        *colors++ = this->palette_[row[x]];
+      }
+      break;
+    case 16:
+      for (; x < end; x++) {
+        uint32_t pixel = read_le16(row + x * 2);
+        *colors++ = Color(this->red_.get(pixel, 0), this->green_.get(pixel, 0), this->blue_.get(pixel, 0),
+                          this->alpha_.get(pixel, 0xFF));
+      }
+      break;
+    case 24:
+      for (; x < end; x++) {
+        const uint8_t *pixel = row + x * 3;
+        *colors++ = Color(pixel[2], pixel[1], pixel[0]);
+      }
+      break;
+    case 32:
+      for (; x < end; x++) {
+        uint32_t pixel = read_le32(row + x * 4);
+        *colors++ = Color(this->red_.get(pixel, 0), this->green_.get(pixel, 0), this->blue_.get(pixel, 0),
+                          this->alpha_.get(pixel, 0xFF));
+      }
+      break;
+  }
+}
 
-    if (!this->set_size(this->width_, this->height_)) {
-      return DECODE_ERROR_OUT_OF_MEMORY;
+size_t BmpDecoder::decode_rle_(const uint8_t *data, size_t size) {
+  /**
+   * RLE opcodes are pairs of bytes:
+   * - count > 0: run of `count` pixels; RLE4 alternates the two colors in the second byte.
+   * - 0, 0: end of line
+   * - 0, 1: end of bitmap
+   * - 0, 2, dx, dy: move the current position
+   * - 0, n >= 3: n pixels follow uncompressed, padded to 16 bits
+   */
+  size_t consumed = 0;
+  while (this->state_ == STATE_PIXELS) {
+    const uint8_t *opcode = data + consumed;
+    size_t available = size - consumed;
+    if (available < 2) {
+      break;
+    }
+    uint8_t count = opcode[0];
+    uint8_t value = opcode[1];
+    if (count > 0) {
+      this->draw_rle_run_(count, value);
+      consumed += 2;
+    } else if (value == 0) {
+      this->skip_rle_(this->current_row_ + 1, 0);
+      consumed += 2;
+    } else if (value == 1) {
+      this->skip_rle_(this->height_, 0);
+      this->state_ = STATE_TRAILER;
+      consumed += 2;
+    } else if (value == 2) {
+      if (available < 4) {
+        break;
+      }
+      this->skip_rle_(this->current_row_ + opcode[3], this->x_ + opcode[2]);
+      consumed += 4;
+    } else {
+      size_t bytes = this->compression_ == COMPRESSION_RLE8 ? value : (value + 1u) / 2u;
+      bytes += bytes & 1;
+      if (available < 2 + bytes) {
+        break;
+      }
+      this->draw_rle_absolute_(opcode + 2, value);
+      consumed += 2 + bytes;
     }
-    this->current_index_ = this->data_offset_;
-    index = this->data_offset_;
-  }
-  while (index < size) {
-    size_t paint_index = this->current_index_ - this->data_offset_;
-
-    uint8_t current_byte = buffer[index];
-    for (uint8_t i = 0; i < 8; i++) {
-      size_t x = (paint_index * 8) % this->width_ + i;
-      size_t y = (this->height_ - 1) - (paint_index / this->width_bytes_);
-      Color c = (current_byte & (1 << (7 - i))) ? display::COLOR_ON : display::COLOR_OFF;
-      this->draw(x, y, 1, 1, c);
+    if (this->current_row_ >= this->height_) {
+      this->state_ = STATE_TRAILER;
+    }
+  }
+  return consumed;
+}
+
+void BmpDecoder::draw_rle_run_(uint8_t count, uint8_t value) {
+  int x = this->x_;
+  this->x_ += count;
+  int end = std::min(this->x_, this->width_);
+  if (x >= end) {
+    return;
+  }
+  int y = this->current_y_();
+  if (this->compression_ == COMPRESSION_RLE8 || (value >> 4) == (value & 0x0F)) {
+    this->draw(x, y, end - x, 1, this->palette_[this->compression_ == COMPRESSION_RLE8 ? value : value & 0x0F]);
+    return;
+  }
+  for (int i = 0; x < end; x++, i++) {
+    this->draw(x, y, 1, 1, this->palette_[(i & 1) ? value & 0x0F : value >> 4]);
+  }
+}
+
+void BmpDecoder::draw_rle_absolute_(const uint8_t *data, uint8_t count) {
+  int y = this->current_y_();
+  int end = std::min(this->x_ + count, this->width_);
+  for (int i = 0, x = this->x_; x < end; x++, i++) {
+    uint8_t index = this->compression_ == COMPRESSION_RLE8 ? data[i] : (data[i >> 1] >> ((i & 1) ? 0 : 4)) & 0x0F;
+    this->draw(x, y, 1, 1, this->palette_[index]);
+  }
+  this->x_ += count;
+}
+
+void BmpDecoder::skip_rle_(int row, int x) {
+  // The buffer may hold a previous image, so skipped pixels are cleared as transparent.
+  while (this->current_row_ < std::min(row, this->height_)) {
+    if (this->x_ < this->width_) {
+      this->draw(this->x_, this->current_y_(), this->width_ - this->x_, 1, Color(0, 0, 0, 0));
     }
-    this->current_index_++;
-    index++;
+    this->current_row_++;
+    this->x_ = 0;
+  }
+  this->current_row_ = row;
+  if (row < this->height_ && this->x_ < std::min(x, this->width_)) {
+    this->draw(this->x_, this->current_y_(), std::min(x, this->width_) - this->x_, 1, Color(0, 0, 0, 0));
   }
-  this->decoded_bytes_ += size;
-  return size;
-};
+  this->x_ = x;
+}
 
 }  // namespace online_image
 }  // namespace esphome
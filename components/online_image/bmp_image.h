@@ -5,11 +5,18 @@
 
 #include "image_decoder.h"
 
+#include <vector>
+
 namespace esphome {
 namespace online_image {
 
 /**
- * @brief Image decoder specialization for PNG images.
+ * @brief Image decoder specialization for BMP images.
+ *
+ * Supports 1, 4 and 8 bits per pixel with a color table, 16, 24 and 32 bits per pixel,
+ * bit field masks, RLE4 and RLE8 compression, and both bottom-up and top-down row order.
+ * The image is decoded while streaming; uncompressed pixel data is consumed a whole row
+ * at a time.
  */
 class BmpDecoder : public ImageDecoder {
  public:
@@ -21,17 +28,89 @@ class BmpDecoder : public ImageDecoder {
   BmpDecoder(OnlineImage *image) : ImageDecoder(image) {}
 
   int HOT decode(uint8_t *buffer, size_t size) override;
+  bool is_progressive() const override { return this->draws_in_raster_order_(); }
 
  protected:
-  size_t current_index_{0};
-  ssize_t width_{0};
-  ssize_t height_{0};
-  uint16_t bits_per_pixel_{0};
-  uint32_t compression_method_{0};
-  uint32_t image_data_size_{0};
-  uint32_t color_table_entries_{0};
-  size_t width_bytes_{0};
+  enum State {
+    STATE_HEADER,
+    STATE_PALETTE,
+    /** Bytes between the headers and the pixel data. */
+    STATE_GAP,
+    STATE_PIXELS,
+    /** Anything after the pixel data. */
+    STATE_TRAILER,
+  };
+
+  enum Compression : uint32_t {
+    COMPRESSION_RGB = 0,
+    COMPRESSION_RLE8 = 1,
+    COMPRESSION_RLE4 = 2,
+    COMPRESSION_BITFIELDS = 3,
+    COMPRESSION_ALPHABITFIELDS = 6,
+  };
+
+  /** Extracts one color channel of a 16 or 32 bit pixel. */
+  struct ChannelMask {
+    uint32_t mask{0};
+    uint8_t shift{0};
+    uint32_t max{0};
+
+    void set(uint32_t mask);
+    uint8_t get(uint32_t pixel, uint8_t fallback) const {
+      if (this->max == 0) {
+        return fallback;
+      }
+      uint32_t value = (pixel & this->mask) >> this->shift;
+      // Masks may be up to 32 bits wide.
+      return this->max == 255 ? value : uint64_t(value) * 255 / this->max;
+    }
+  };
+
+  /** Top-down uncompressed images arrive row by row from the top. */
+  bool draws_in_raster_order_() const override {
+    return this->top_down_ && this->compression_ != COMPRESSION_RLE8 && this->compression_ != COMPRESSION_RLE4;
+  }
+
+  /** @return The size of the headers, 0 if more data is needed, or a {@see DecodeError}. */
+  int parse_header_(const uint8_t *data, size_t size);
+  size_t read_palette_(const uint8_t *data, size_t size);
+  size_t skip_gap_(size_t size);
+  size_t decode_rows_(const uint8_t *data, size_t size);
+  void decode_row_(const uint8_t *row, int y);
+  /** Convert count pixels of a row of uncompressed pixel data, starting at column x. */
+  void convert_pixels_(const uint8_t *row, int x, int count, Color *colors) const;
+  size_t decode_rle_(const uint8_t *data, size_t size);
+  void draw_rle_run_(uint8_t count, uint8_t value);
+  void draw_rle_absolute_(const uint8_t *data, uint8_t count);
+  /** Clear the pixels an RLE escape skips, up to column x of the given row of pixel data. */
+  void skip_rle_(int row, int x);
+  /** Image row of the current row of pixel data. */
+  int current_y_() const { return this->top_down_ ? this->current_row_ : this->height_ - 1 - this->current_row_; }
+
+  State state_{STATE_HEADER};
+  /** Offset in the file of the next byte to decode. */
+  size_t position_{0};
   size_t data_offset_{0};
+  int width_{0};
+  int height_{0};
+  bool top_down_{false};
+  uint16_t bits_per_pixel_{0};
+  uint32_t compression_{COMPRESSION_RGB};
+  /** Bytes per row of uncompressed pixel data, including the padding to 4 bytes. */
+  size_t row_bytes_{0};
+  int current_row_{0};
+  /** Horizontal position within the current row, for RLE. */
+  int x_{0};
+
+  std::vector<Color> palette_;
+  size_t palette_entries_{0};
+  size_t palette_read_{0};
+  /** 4 bytes per color table entry, or 3 for OS/2 headers. */
+  size_t palette_entry_size_{4};
+  ChannelMask red_;
+  ChannelMask green_;
+  ChannelMask blue_;
+  ChannelMask alpha_;
 };
 
 }  // namespace online_image
@@ -0,0 +1,128 @@
+#include "frame_store.h"
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace online_image {
+
+static const char *const TAG = "online_image.frames";
+
+/** Size of the header in front of every span of changed bytes. */
+static const size_t SPAN_HEADER_SIZE = 4;
+static const size_t SPAN_MAX = 0xFFFF;
+
+FrameStore::~FrameStore() {
+  if (this->data_) {
+    this->allocator_.deallocate(this->data_, this->data_size_);
+  }
+}
+
+bool FrameStore::encode(const uint8_t *frames, size_t frame_size, uint32_t frame_count) {
+  this->frame_size_ = frame_size;
+  this->offsets_.resize(frame_count + 1);
+
+  // First pass only measures, so that a single block of the exact size can be allocated.
+  size_t total = frame_size;
+  for (uint32_t frame = 1; frame < frame_count; frame++) {
+    total += this->encode_delta_(frames + (frame - 1) * frame_size, frames + frame * frame_size, nullptr);
+  }
+  this->data_ = this->allocator_.allocate(total);
+  if (this->data_ == nullptr) {
+    ESP_LOGE(TAG, "allocation of %zu bytes failed. Biggest block in heap: %zu Bytes", total,
+             this->allocator_.get_max_free_block_size());
+    return false;
+  }
+  this->data_size_ = total;
+
+  memcpy(this->data_, frames, frame_size);
+  size_t offset = frame_size;
+  this->offsets_[0] = 0;
+  for (uint32_t frame = 1; frame < frame_count; frame++) {
+    this->offsets_[frame] = offset;
+    offset += this->encode_delta_(frames + (frame - 1) * frame_size, frames + frame * frame_size, this->data_ + offset);
+  }
+  this->offsets_[frame_count] = offset;
+  return true;
+}
+
+size_t FrameStore::encode_delta_(const uint8_t *prev, const uint8_t *cur, uint8_t *out) const {
+  size_t written = 0;
+  size_t last_end = 0;
+  auto emit = [&](size_t skip, size_t start, size_t len) {
+    if (out) {
+      out[written + 0] = skip & 0xFF;
+      out[written + 1] = skip >> 8;
+      out[written + 2] = len & 0xFF;
+      out[written + 3] = len >> 8;
+      memcpy(out + written + SPAN_HEADER_SIZE, cur + start, len);
+    }
+    written += SPAN_HEADER_SIZE + len;
+  };
+
+  size_t pos = 0;
+  while (pos < this->frame_size_) {
+    if (cur[pos] == prev[pos]) {
+      pos++;
+      continue;
+    }
+    size_t start = pos;
+    size_t end = pos + 1;
+    // Extend the span over short runs of unchanged bytes; splitting it would cost more than copying them.
+    while (end < this->frame_size_ && end - start < SPAN_MAX) {
+      if (cur[end] != prev[end]) {
+        end++;
+        continue;
+      }
+      size_t run = 0;
+      while (end + run < this->frame_size_ && run < SPAN_HEADER_SIZE && cur[end + run] == prev[end + run]) {
+        run++;
+      }
+      if (run >= SPAN_HEADER_SIZE || end + run == this->frame_size_) {
+        break;
+      }
+      end = std::min(end + run, start + SPAN_MAX);
+    }
+    size_t skip = start - last_end;
+    while (skip > SPAN_MAX) {
+      // Empty spans move the position forward over long unchanged areas.
+      emit(SPAN_MAX, start, 0);
+      skip -= SPAN_MAX;
+    }
+    emit(skip, start, end - start);
+    last_end = end;
+    pos = end;
+  }
+  return written;
+}
+
+void FrameStore::apply_delta_(uint8_t *target, int frame) const {
+  const uint8_t *p = this->data_ + this->offsets_[frame];
+  const uint8_t *end = this->data_ + this->offsets_[frame + 1];
+  size_t pos = 0;
+  while (p < end) {
+    size_t skip = p[0] | (p[1] << 8);
+    size_t len = p[2] | (p[3] << 8);
+    p += SPAN_HEADER_SIZE;
+    pos += skip;
+    memcpy(target + pos, p, len);
+    p += len;
+    pos += len;
+  }
+}
+
+void FrameStore::restore(uint8_t *target, int current, int frame) const {
+  if (frame == current) {
+    return;
+  }
+  if (frame == current + 1) {
+    this->apply_delta_(target, frame);
+    return;
+  }
+  memcpy(target, this->data_, this->frame_size_);
+  for (int i = 1; i <= frame; i++) {
+    this->apply_delta_(target, i);
+  }
+}
+
+}  // namespace online_image
+}  // namespace esphome
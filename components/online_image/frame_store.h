@@ -0,0 +1,64 @@
+#pragma once
+
+#include "esphome/core/helpers.h"
+
+#include <vector>
+
+namespace esphome {
+namespace online_image {
+
+/**
+ * @brief Compressed storage for the frames of an animated image.
+ *
+ * The first frame is kept as a raw keyframe; every following frame is stored as a list of
+ * spans of bytes that differ from the previous frame. Frames are reconstructed one at a time
+ * into a single working frame, so only the differences need to stay resident.
+ *
+ * Delta format, repeated until the end of the frame's data:
+ * 0-1: Number of unchanged bytes to skip since the end of the previous span (little-endian)
+ * 2-3: Number of changed bytes that follow (little-endian)
+ * 4-n: The changed bytes
+ */
+class FrameStore {
+ public:
+  ~FrameStore();
+
+  /**
+   * @brief Build the store from a buffer holding all frames back to back.
+   *
+   * @param frames Pointer to the first frame.
+   * @param frame_size Size in bytes of a single frame.
+   * @param frame_count Number of frames in the buffer.
+   * @return true if the frames were stored, false if not enough memory is available.
+   */
+  bool encode(const uint8_t *frames, size_t frame_size, uint32_t frame_count);
+
+  /**
+   * @brief Reconstruct a frame into the working frame.
+   *
+   * Advancing by one frame only applies a single delta; any other jump rebuilds the frame
+   * starting from the keyframe.
+   *
+   * @param target The working frame, currently holding frame `current`.
+   * @param current The frame currently held in the working frame.
+   * @param frame The frame to reconstruct.
+   */
+  void restore(uint8_t *target, int current, int frame) const;
+
+  /** Total number of bytes used to store all frames. */
+  size_t size() const { return this->data_size_; }
+
+ protected:
+  size_t encode_delta_(const uint8_t *prev, const uint8_t *cur, uint8_t *out) const;
+  void apply_delta_(uint8_t *target, int frame) const;
+
+  RAMAllocator<uint8_t> allocator_{};
+  uint8_t *data_{nullptr};
+  size_t data_size_{0};
+  size_t frame_size_{0};
+  /** Offset in data_ of each frame's delta; the last entry marks the end of the data. */
+  std::vector<size_t> offsets_;
+};
+
+}  // namespace online_image
+}  // namespace esphome
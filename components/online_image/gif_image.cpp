@@ -0,0 +1,491 @@
+#include "gif_image.h"
+
+#ifdef USE_ONLINE_IMAGE_GIF_SUPPORT
+
+#include "esphome/core/log.h"
+
+#include "online_image.h"
+
+#include <cinttypes>
+
+namespace esphome {
+namespace online_image {
+
+static const char *const TAG = "online_image.gif";
+
+/** GIF codes are at most 12 bits wide. */
+static const int MAX_CODES = 4096;
+static const size_t TABLES_SIZE = MAX_CODES * (sizeof(uint16_t) + 2);
+
+static const uint8_t BLOCK_EXTENSION = 0x21;
+static const uint8_t BLOCK_IMAGE = 0x2C;
+static const uint8_t BLOCK_TRAILER = 0x3B;
+static const uint8_t EXTENSION_GRAPHIC_CONTROL = 0xF9;
+
+static inline uint16_t read_le16(const uint8_t *p) { return encode_uint16(p[1], p[0]); }
+
+/** @return The offset after the sub-blocks starting at pos. */
+static size_t skip_sub_blocks(const uint8_t *file, size_t size, size_t pos) {
+  while (pos < size) {
+    uint8_t length = file[pos++];
+    if (length == 0) {
+      break;
+    }
+    pos += length;
+  }
+  return std::min(pos, size);
+}
+
+GifDecoder::~GifDecoder() {
+  if (this->tables_) {
+    this->allocator_.deallocate(this->tables_, TABLES_SIZE);
+  }
+  if (this->file_) {
+    this->allocator_.deallocate(this->file_, this->file_capacity_);
+  }
+}
+
+int GifDecoder::prepare(size_t download_size) {
+  ImageDecoder::prepare(download_size);
+  if (download_size == DOWNLOAD_SIZE_UNKNOWN) {
+    // The download buffer grows while the image is being downloaded.
+    return 0;
+  }
+  auto size = this->image_->resize_download_buffer(download_size);
+  if (size < download_size) {
+    ESP_LOGE(TAG, "Download buffer resize failed!");
+    return DECODE_ERROR_OUT_OF_MEMORY;
+  }
+  return 0;
+}
+
+int HOT GifDecoder::decode(uint8_t *buffer, size_t size) {
+  if (size < this->download_size_) {
+    ESP_LOGV(TAG, "Download not complete. Size: %zu/%zu", size, this->download_size_);
+    return 0;
+  }
+  if (!this->parse_(buffer, size)) {
+    return DECODE_ERROR_INVALID_TYPE;
+  }
+  int frames = this->frames_.size();
+  bool on_demand = this->on_demand_ && frames > 1;
+  ESP_LOGD(TAG, "GIF %dx%d, %d frames%s", this->width_, this->height_, frames, on_demand ? ", decoded on demand" : "");
+
+  this->tables_ = this->allocator_.allocate(TABLES_SIZE);
+  if (!this->tables_) {
+    ESP_LOGE(TAG, "Could not allocate the LZW dictionary");
+    return DECODE_ERROR_OUT_OF_MEMORY;
+  }
+  this->prefix_ = reinterpret_cast<uint16_t *>(this->tables_);
+  this->suffix_ = this->tables_ + MAX_CODES * sizeof(uint16_t);
+  this->stack_ = this->suffix_ + MAX_CODES;
+
+  // A single frame covering the whole canvas is drawn in raster order, so it can be resampled smoothly.
+  const Frame &first = this->frames_[0];
+  this->raster_ = frames == 1 && !first.interlaced && first.x == 0 && first.y == 0 && first.width == this->width_ &&
+                  first.height == this->height_;
+  if (!this->set_size(this->width_, this->height_, on_demand ? 1 : frames)) {
+    return DECODE_ERROR_OUT_OF_MEMORY;
+  }
+  for (int i = 0; i < frames; i++) {
+    this->set_frame_duration(i, this->frames_[i].delay_ms);
+  }
+
+  if (on_demand) {
+    // Keep the compressed frames where they were downloaded; the next download gets a new buffer.
+    size_t capacity;
+    this->file_ = this->image_->take_download_buffer(&capacity);
+    if (!this->file_) {
+      return DECODE_ERROR_OUT_OF_MEMORY;
+    }
+    this->file_size_ = size;
+    this->file_capacity_ = capacity;
+    if (capacity > size) {
+      // The download buffer grows in steps; give back what the file does not use.
+      uint8_t *file = this->allocator_.reallocate(this->file_, size);
+      if (file) {
+        this->file_ = file;
+        this->file_capacity_ = size;
+      }
+    }
+    if (!this->render_(0)) {
+      return DECODE_ERROR_INVALID_TYPE;
+    }
+    // Nothing is left in the download buffer to read.
+    this->decoded_bytes_ = size;
+    return 0;
+  }
+  for (int i = 0; i < frames; i++) {
+    this->feed_wdt();
+    if (!this->compose_(buffer, size, i, i)) {
+      return DECODE_ERROR_INVALID_TYPE;
+    }
+  }
+  this->allocator_.deallocate(this->tables_, TABLES_SIZE);
+  this->tables_ = nullptr;
+
+  this->decoded_bytes_ = size;
+  return size;
+}
+
+bool GifDecoder::parse_(const uint8_t *file, size_t size) {
+  /**
+   * GIF header:
+   * 0-5: Signature (GIF87a or GIF89a)
+   * 6-7: Logical screen width
+   * 8-9: Logical screen height
+   * 10: Flags; bit 7: global color table, bits 0-2: log2(color table size) - 1
+   * 11: Background color index
+   * 12: Pixel aspect ratio
+   *
+   * Integer values are stored in little-endian format.
+   */
+  if (size < 13 || memcmp(file, "GIF", 3) != 0) {
+    ESP_LOGE(TAG, "Not a GIF file");
+    return false;
+  }
+  this->width_ = read_le16(file + 6);
+  this->height_ = read_le16(file + 8);
+  if (this->width_ == 0 || this->height_ == 0) {
+    ESP_LOGE(TAG, "Invalid image size: %dx%d", this->width_, this->height_);
+    return false;
+  }
+  size_t pos = 13;
+  if (file[10] & 0x80) {
+    this->global_palette_offset_ = pos;
+    this->global_palette_size_ = 2 << (file[10] & 0x07);
+    pos += 3 * this->global_palette_size_;
+  }
+
+  // Graphic control extension applying to the next image
+  Disposal disposal = DISPOSAL_NONE;
+  uint32_t delay_ms = 0;
+  bool transparent = false;
+  uint8_t transparent_index = 0;
+  // Canvas of the next frame
+  int base_frame = -1;
+  int base_clear = -1;
+
+  this->frames_.clear();
+  while (pos < size) {
+    uint8_t block = file[pos++];
+    if (block == BLOCK_TRAILER) {
+      break;
+    }
+    if (block == BLOCK_EXTENSION) {
+      if (pos >= size) {
+        break;
+      }
+      uint8_t label = file[pos++];
+      if (label == EXTENSION_GRAPHIC_CONTROL && pos + 5 < size && file[pos] == 4) {
+        /**
+         * Graphic control extension:
+         * 0: Block size (4)
+         * 1: Flags; bits 2-4: disposal method, bit 0: transparent color
+         * 2-3: Delay time, in hundredths of a second
+         * 4: Transparent color index
+         */
+        disposal = static_cast<Disposal>((file[pos + 1] >> 2) & 0x07);
+        transparent = file[pos + 1] & 0x01;
+        delay_ms = read_le16(file + pos + 2) * 10u;
+        transparent_index = file[pos + 4];
+      }
+      pos = skip_sub_blocks(file, size, pos);
+    } else if (block == BLOCK_IMAGE) {
+      /**
+       * Image descriptor:
+       * 0-1: Left
+       * 2-3: Top
+       * 4-5: Width
+       * 6-7: Height
+       * 8: Flags; bit 7: local color table, bit 6: interlaced, bits 0-2: log2(color table size) - 1
+       */
+      if (pos + 9 > size) {
+        break;
+      }
+      Frame frame{};
+      frame.x = read_le16(file + pos);
+      frame.y = read_le16(file + pos + 2);
+      frame.width = read_le16(file + pos + 4);
+      frame.height = read_le16(file + pos + 6);
+      uint8_t flags = file[pos + 8];
+      pos += 9;
+      frame.interlaced = flags & 0x40;
+      if (flags & 0x80) {
+        frame.palette_offset = pos;
+        frame.palette_size = 2 << (flags & 0x07);
+        pos += 3 * frame.palette_size;
+      } else {
+        frame.palette_offset = this->global_palette_offset_;
+        frame.palette_size = this->global_palette_size_;
+      }
+      if (pos >= size) {
+        break;
+      }
+      frame.data_offset = pos;
+      pos = skip_sub_blocks(file, size, pos + 1);
+      frame.delay_ms = delay_ms;
+      frame.disposal = disposal;
+      frame.transparent = transparent;
+      frame.transparent_index = transparent_index;
+      frame.base_frame = base_frame;
+      frame.base_clear = base_clear;
+
+      int index = this->frames_.size();
+      this->frames_.push_back(frame);
+      if (disposal == DISPOSAL_BACKGROUND) {
+        // Browsers clear to transparent rather than to the background color
+        base_frame = index;
+        base_clear = index;
+      } else if (disposal != DISPOSAL_PREVIOUS) {
+        base_frame = index;
+        base_clear = -1;
+      }
+      disposal = DISPOSAL_NONE;
+      delay_ms = 0;
+      transparent = false;
+    } else {
+      ESP_LOGW(TAG, "Unknown block 0x%02X at %zu; ignoring the rest of the file", block, pos - 1);
+      break;
+    }
+  }
+  if (this->frames_.empty()) {
+    ESP_LOGE(TAG, "No frames found");
+    return false;
+  }
+  return true;
+}
+
+bool GifDecoder::compose_(const uint8_t *file, size_t size, int index, int target) {
+  const Frame &frame = this->frames_[index];
+  if (frame.base_frame < 0) {
+    if (!this->raster_) {
+      this->draw(0, 0, this->width_, this->height_, Color(0, 0, 0, 0), target);
+    }
+  } else {
+    if (!this->file_) {
+      // With on-demand frames, the canvas is already in the single frame.
+      this->copy_frame(frame.base_frame, target);
+    }
+    if (frame.base_clear >= 0) {
+      this->clear_(frame.base_clear, target);
+    }
+  }
+  return this->decompress_(file, size, frame, target);
+}
+
+void GifDecoder::clear_(int frame_index, int target) {
+  const Frame &frame = this->frames_[frame_index];
+  int width = std::min<int>(frame.width, this->width_ - frame.x);
+  int height = std::min<int>(frame.height, this->height_ - frame.y);
+  if (width > 0 && height > 0) {
+    this->draw(frame.x, frame.y, width, height, Color(0, 0, 0, 0), target);
+  }
+}
+
+bool HOT GifDecoder::decompress_(const uint8_t *file, size_t size, const Frame &frame, int target) {
+  size_t pos = frame.data_offset;
+  const int min_code_size = file[pos++];
+  if (min_code_size < 2 || min_code_size > 8) {
+    ESP_LOGE(TAG, "Invalid LZW code size: %d", min_code_size);
+    return false;
+  }
+  const int clear_code = 1 << min_code_size;
+  const int end_code = clear_code + 1;
+  for (int i = 0; i < clear_code; i++) {
+    this->prefix_[i] = 0;
+    this->suffix_[i] = i;
+  }
+  int code_size = min_code_size + 1;
+  int next_code = clear_code + 2;
+  int prev_code = -1;
+  uint8_t first = 0;
+
+  // Bit reader over the data sub-blocks
+  uint32_t bits = 0;
+  int bit_count = 0;
+  size_t block_left = 0;
+
+  // Output position, in frame coordinates
+  static const uint8_t PASS_START[] = {0, 4, 2, 1};
+  static const uint8_t PASS_STEP[] = {8, 8, 4, 2};
+  const uint8_t *palette = frame.palette_offset ? file + frame.palette_offset : nullptr;
+  const uint32_t total = uint32_t(frame.width) * frame.height;
+  uint32_t count = 0;
+  int x = 0;
+  int y = 0;
+  int pass = 0;
+
+  auto put = [&](uint8_t index) {
+    int screen_x = frame.x + x;
+    int screen_y = frame.y + y;
+    if (screen_x < this->width_ && screen_y < this->height_) {
+      if (!(frame.transparent && index == frame.transparent_index)) {
+        Color color(0, 0, 0);
+        if (palette && index < frame.palette_size) {
+          const uint8_t *rgb = palette + index * 3;
+          color = Color(rgb[0], rgb[1], rgb[2]);
+        }
+        this->draw(screen_x, screen_y, 1, 1, color, target);
+      } else if (this->raster_) {
+        // The canvas has not been cleared underneath.
+        this->draw(screen_x, screen_y, 1, 1, Color(0, 0, 0, 0), target);
+      }
+    }
+    count++;
+    if (++x == frame.width) {
+      x = 0;
+      if (!frame.interlaced) {
+        y++;
+      } else {
+        y += PASS_STEP[pass];
+        while (y >= frame.height && pass < 3) {
+          pass++;
+          y = PASS_START[pass];
+        }
+      }
+    }
+  };
+
+  // Whether the file ends within the image data, without its terminating block
+  bool truncated = false;
+  /** @return The next code, or -1 at the end of the image data. */
+  auto read_code = [&]() -> int {
+    while (bit_count < code_size) {
+      if (block_left == 0) {
+        if (pos >= size) {
+          truncated = true;
+          return -1;
+        }
+        block_left = file[pos++];
+        if (block_left == 0) {
+          return -1;
+        }
+      }
+      if (pos >= size) {
+        truncated = true;
+        return -1;
+      }
+      bits |= file[pos++] << bit_count;
+      bit_count += 8;
+      block_left--;
+    }
+    int code = bits & ((1 << code_size) - 1);
+    bits >>= code_size;
+    bit_count -= code_size;
+    return code;
+  };
+
+  while (count < total) {
+    int code = read_code();
+    if (code < 0) {
+      if (truncated) {
+        ESP_LOGE(TAG, "Image data truncated after %" PRIu32 " of %" PRIu32 " pixels", count, total);
+        return false;
+      }
+      // End of the image data; whatever is missing stays as it was.
+      break;
+    }
+
+    if (code == clear_code) {
+      code_size = min_code_size + 1;
+      next_code = clear_code + 2;
+      prev_code = -1;
+      continue;
+    }
+    if (code == end_code) {
+      break;
+    }
+    if (prev_code < 0) {
+      if (code >= clear_code) {
+        ESP_LOGE(TAG, "Invalid first LZW code %d", code);
+        return false;
+      }
+      first = code;
+      prev_code = code;
+      put(code);
+      continue;
+    }
+
+    int in_code = code;
+    int sp = 0;
+    if (code > next_code || code >= MAX_CODES) {
+      ESP_LOGE(TAG, "Invalid LZW code %d", code);
+      return false;
+    }
+    if (code == next_code) {
+      this->stack_[sp++] = first;
+      code = prev_code;
+    }
+    while (code >= clear_code) {
+      this->stack_[sp++] = this->suffix_[code];
+      code = this->prefix_[code];
+      if (sp >= MAX_CODES) {
+        ESP_LOGE(TAG, "LZW string too long");
+        return false;
+      }
+    }
+    first = code;
+    this->stack_[sp++] = first;
+
+    if (next_code < MAX_CODES) {
+      this->prefix_[next_code] = prev_code;
+      this->suffix_[next_code] = first;
+      next_code++;
+      if (next_code == (1 << code_size) && code_size < 12) {
+        code_size++;
+      }
+    }
+    prev_code = in_code;
+    while (sp > 0 && count < total) {
+      put(this->stack_[--sp]);
+    }
+  }
+  if (this->raster_) {
+    // Nothing was drawn underneath the missing pixels.
+    for (; count < total; count++) {
+      this->draw(count % frame.width, count / frame.width, 1, 1, Color(0, 0, 0, 0), target);
+    }
+  }
+  return true;
+}
+
+bool GifDecoder::render_(int frame) {
+  if (frame == this->shown_frame_) {
+    return true;
+  }
+  // Go back through the canvases the frame is built on, until one is the frame shown now.
+  std::vector<int> chain;
+  for (int index = frame;;) {
+    chain.push_back(index);
+    int base = this->frames_[index].base_frame;
+    if (base < 0 || base == this->shown_frame_) {
+      break;
+    }
+    index = base;
+  }
+  for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+    this->shown_frame_ = -1;
+    if (!this->compose_(this->file_, this->file_size_, *it, 0)) {
+      return false;
+    }
+    this->shown_frame_ = *it;
+  }
+  return true;
+}
+
+bool GifDecoder::render_frame(int frame) {
+  if (!this->file_ || frame < 0 || frame >= static_cast<int>(this->frames_.size())) {
+    return false;
+  }
+  return this->render_(frame);
+}
+
+int GifDecoder::get_on_demand_frames() const { return this->file_ ? this->frames_.size() : 0; }
+
+size_t GifDecoder::get_retained_size() const { return this->file_ ? this->file_capacity_ + TABLES_SIZE : 0; }
+
+}  // namespace online_image
+}  // namespace esphome
+
+#endif  // USE_ONLINE_IMAGE_GIF_SUPPORT
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#ifdef USE_ONLINE_IMAGE_GIF_SUPPORT
+
+#include "esphome/core/helpers.h"
+
+#include "image_decoder.h"
+
+#include <vector>
+
+namespace esphome {
+namespace online_image {
+
+/**
+ * @brief Image decoder specialization for (animated) GIF images.
+ *
+ * Like WebP, the whole file is downloaded first, so that the number of frames is known
+ * when the image buffer is allocated. The frames are then decompressed one at a time
+ * with a fixed-size LZW dictionary, and composed according to their disposal methods.
+ *
+ * With on-demand frames, the image buffer only holds a single frame. The compressed file
+ * is kept instead, in the memory it was downloaded to, and each frame is decoded when it is shown.
+ */
+class GifDecoder : public ImageDecoder {
+ public:
+  /**
+   * @brief Construct a new GIF Decoder object.
+   *
+   * @param image The image to decode the stream into.
+   * @param on_demand_frames Keep the compressed file and decode frames when they are shown.
+   */
+  GifDecoder(OnlineImage *image, bool on_demand_frames) : ImageDecoder(image), on_demand_(on_demand_frames) {}
+  ~GifDecoder() override;
+
+  int prepare(size_t download_size) override;
+  int HOT decode(uint8_t *buffer, size_t size) override;
+
+  bool render_frame(int frame) override;
+  int get_on_demand_frames() const override;
+  /** Frames are composed on top of earlier frames in the image buffer. */
+  bool can_drop_frames() const override { return false; }
+  size_t get_retained_size() const override;
+
+ protected:
+  enum Disposal : uint8_t {
+    DISPOSAL_NONE = 0,
+    DISPOSAL_KEEP = 1,
+    DISPOSAL_BACKGROUND = 2,
+    DISPOSAL_PREVIOUS = 3,
+  };
+
+  /** Only a single, non-interlaced frame covering the whole canvas is drawn in raster order. */
+  bool draws_in_raster_order_() const override { return this->raster_; }
+
+  struct Frame {
+    /** Offset of the LZW minimum code size, followed by the data sub-blocks. */
+    size_t data_offset;
+    /** Offset of the color table used by the frame, or 0 if there is none. */
+    size_t palette_offset;
+    uint16_t palette_size;
+    uint16_t x, y, width, height;
+    /** Delay after the frame, in milliseconds. */
+    uint32_t delay_ms;
+    Disposal disposal;
+    bool interlaced;
+    bool transparent;
+    uint8_t transparent_index;
+    /**
+     * The canvas the frame is drawn on: frame `base_frame`, with `base_clear` cleared
+     * to transparent, or an empty canvas if base_frame is -1.
+     */
+    int base_frame;
+    int base_clear;
+  };
+
+  /** Walk through all blocks of the file, and collect the frames. */
+  bool parse_(const uint8_t *file, size_t size);
+  /** Prepare the canvas of the frame in `target`, then decompress the frame on top of it. */
+  bool compose_(const uint8_t *file, size_t size, int index, int target);
+  /** Decompress the pixels of a frame into `target`. */
+  bool decompress_(const uint8_t *file, size_t size, const Frame &frame, int target);
+  void clear_(int frame_index, int target);
+  /** Decode the given frame into the single frame buffer, starting from the frame shown now. */
+  bool render_(int frame);
+
+  bool on_demand_;
+  /** Whether the image is a single frame drawing every pixel of the canvas in raster order. */
+  bool raster_{false};
+  int width_{0};
+  int height_{0};
+  size_t global_palette_offset_{0};
+  uint16_t global_palette_size_{0};
+  std::vector<Frame> frames_;
+
+  RAMAllocator<uint8_t> allocator_{};
+  /** LZW dictionary (prefix code and last byte of every string) and output stack, in one allocation. */
+  uint8_t *tables_{nullptr};
+  uint16_t *prefix_{nullptr};
+  uint8_t *suffix_{nullptr};
+  uint8_t *stack_{nullptr};
+
+  /** The file, taken over from the download buffer for on-demand frames. */
+  uint8_t *file_{nullptr};
+  size_t file_size_{0};
+  /** Size of the allocation holding the file. */
+  size_t file_capacity_{0};
+  /** Frame currently in the image buffer, for on-demand frames. */
+  int shown_frame_{-1};
+};
+
+}  // namespace online_image
+}  // namespace esphome
+
+#endif  // USE_ONLINE_IMAGE_GIF_SUPPORT
@@ -0,0 +1,63 @@
+#include "image_cache.h"
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace online_image {
+
+static const char *const TAG = "online_image.cache";
+
+void ImageCache::put(CachedImage &&image) {
+  size_t memory = image.memory();
+  if (memory > this->max_size_) {
+    ESP_LOGD(TAG, "Image %s (%zu bytes) does not fit in the cache", image.url.c_str(), memory);
+    this->free_(image);
+    return;
+  }
+  while (this->used_ + memory > this->max_size_ && !this->images_.empty()) {
+    CachedImage &oldest = this->images_.back();
+    ESP_LOGD(TAG, "Evicting %s (%zu bytes)", oldest.url.c_str(), oldest.memory());
+    this->used_ -= oldest.memory();
+    this->free_(oldest);
+    this->images_.pop_back();
+  }
+  ESP_LOGV(TAG, "Caching %s (%zu bytes)", image.url.c_str(), memory);
+  this->used_ += memory;
+  this->images_.push_front(std::move(image));
+}
+
+bool ImageCache::take(const std::string &url, CachedImage &image) {
+  for (auto it = this->images_.begin(); it != this->images_.end(); ++it) {
+    if (it->url == url) {
+      ESP_LOGD(TAG, "Cache hit for %s", url.c_str());
+      this->used_ -= it->memory();
+      image = std::move(*it);
+      this->images_.erase(it);
+      return true;
+    }
+  }
+  ESP_LOGD(TAG, "Cache miss for %s", url.c_str());
+  return false;
+}
+
+void ImageCache::clear() {
+  for (auto &image : this->images_) {
+    this->free_(image);
+  }
+  this->images_.clear();
+  this->used_ = 0;
+}
+
+void ImageCache::free_(CachedImage &image) {
+  if (image.buffer) {
+    this->allocator_.deallocate(image.buffer, image.buffer_size);
+    image.buffer = nullptr;
+  }
+  image.frame_store.reset();
+  image.frame_source.reset();
+  image.palette.reset();
+  image.frame_durations.clear();
+}
+
+}  // namespace online_image
+}  // namespace esphome
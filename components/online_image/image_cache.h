@@ -0,0 +1,94 @@
+#pragma once
+
+#include "esphome/core/helpers.h"
+
+#include "frame_store.h"
+#include "image_decoder.h"
+#include "palette.h"
+
+#include <list>
+#include <string>
+#include <vector>
+
+namespace esphome {
+namespace online_image {
+
+/**
+ * @brief A decoded image, together with everything needed to show it again.
+ */
+struct CachedImage {
+  std::string url;
+  uint8_t *buffer{nullptr};
+  /** Allocated size of buffer. */
+  size_t buffer_size{0};
+  int width{0};
+  int height{0};
+  uint32_t frame_count{1};
+  int frame_size{0};
+  /** Allocated with less colors, frames or pixels than requested, for lack of memory. */
+  bool degraded{false};
+  /** Compressed frames; buffer then only holds the working frame. */
+  std::unique_ptr<FrameStore> frame_store{nullptr};
+  /** Decoder drawing the frames on demand; buffer then only holds the frame shown. */
+  std::unique_ptr<ImageDecoder> frame_source{nullptr};
+  /** Frame reconstructed in the working frame. */
+  int stored_frame{0};
+  /** Colors of an indexed image. */
+  std::unique_ptr<Palette> palette{nullptr};
+  /** Display time of each frame of the buffer, in milliseconds; 0 if unknown. */
+  std::vector<uint32_t> frame_durations;
+  std::string etag;
+  std::string last_modified;
+  /** millis() when the image was last downloaded or confirmed unchanged. */
+  uint32_t fetched_ms{0};
+
+  size_t memory() const {
+    return this->buffer_size + (this->frame_store ? this->frame_store->size() : 0) +
+           (this->frame_source ? this->frame_source->get_retained_size() : 0) + (this->palette ? this->palette->memory() : 0) +
+           this->frame_durations.size() * sizeof(uint32_t);
+  }
+};
+
+/**
+ * @brief Keeps decoded images of several URLs within a memory budget.
+ *
+ * Images are evicted least recently used first. An image taken out of the cache is owned
+ * by the caller until it is put back.
+ */
+class ImageCache {
+ public:
+  /**
+   * @param max_size Maximum number of bytes used by all cached images.
+   * @param max_age_ms Time during which a cached image is used without checking the server.
+   */
+  ImageCache(size_t max_size, uint32_t max_age_ms) : max_size_(max_size), max_age_ms_(max_age_ms) {}
+  ~ImageCache() { this->clear(); }
+
+  /** Store an image, evicting older ones as needed. Images larger than the budget are dropped. */
+  void put(CachedImage &&image);
+
+  /**
+   * @brief Take the image for the given URL out of the cache.
+   *
+   * @return true if the image was cached, and has been moved into `image`.
+   */
+  bool take(const std::string &url, CachedImage &image);
+
+  /** Drop all cached images. */
+  void clear();
+
+  uint32_t get_max_age() const { return this->max_age_ms_; }
+
+ protected:
+  void free_(CachedImage &image);
+
+  RAMAllocator<uint8_t> allocator_{};
+  /** Most recently used first. */
+  std::list<CachedImage> images_;
+  size_t max_size_;
+  size_t used_{0};
+  uint32_t max_age_ms_;
+};
+
+}  // namespace online_image
+}  // namespace esphome
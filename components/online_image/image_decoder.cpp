@@ -1,6 +1,8 @@
 #include "image_decoder.h"
 #include "online_image.h"
 
+#include "esphome/core/application.h"
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
 namespace esphome {
@@ -10,19 +12,59 @@ static const char *const TAG = "online_image.decoder";
 
 bool ImageDecoder::set_size(int width, int height, int frames) {
   bool success = this->image_->resize_(width, height, frames) > 0;
-  this->x_scale_ = static_cast<double>(this->image_->buffer_width_) / width;
-  this->y_scale_ = static_cast<double>(this->image_->buffer_height_) / height;
+  if (this->image_->viewport_) {
+    // The viewport is cut out of the image at its original size.
+    this->resampler_.set_size(width, height, width, height, RESIZE_FILTER_NEAREST);
+    return success;
+  }
+  auto filter = this->draws_in_raster_order_() ? this->image_->resize_filter_ : RESIZE_FILTER_NEAREST;
+  this->resampler_.set_size(width, height, this->image_->buffer_width_, this->image_->buffer_height_, filter);
   return success;
 }
 
 void ImageDecoder::draw(int x, int y, int w, int h, const Color &color, int frame) {
-  auto width = std::min(this->image_->buffer_width_, static_cast<int>(std::ceil((x + w) * this->x_scale_)));
-  auto height = std::min(this->image_->buffer_height_, static_cast<int>(std::ceil((y + h) * this->y_scale_)));
-  for (int i = x * this->x_scale_; i < width; i++) {
-    for (int j = y * this->y_scale_; j < height; j++) {
-      this->image_->draw_pixel_(i, j, color, frame);
+  int step = this->image_->buffer_frame_step_;
+  if (frame % step != 0) {
+    // Frame left out to fit in memory
+    return;
+  }
+  this->resampler_.draw(x, y, w, h, color, frame / step);
+}
+
+bool ImageDecoder::can_store_pixels() const {
+  return this->resampler_.is_identity() && this->image_->buffer_ && !this->image_->viewport_ &&
+         !this->image_->palette_;
+}
+
+void ImageDecoder::store_pixels(int x, int y, const Color *colors, int count) {
+  this->image_->store_pixels_(x, y, colors, count);
+}
+
+void ImageDecoder::copy_frame(int source, int target) { this->image_->copy_frame_(source, target); }
+
+void ImageDecoder::set_frame_duration(int frame, uint32_t duration_ms) {
+  // Frames left out for lack of memory extend the kept frame before them.
+  size_t slot = frame / this->image_->buffer_frame_step_;
+  auto &durations = this->image_->frame_durations_;
+  if (durations.size() <= slot) {
+    durations.resize(slot + 1, 0);
+  }
+  durations[slot] += duration_ms;
+}
+
+void ImageDecoder::feed_wdt() {
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  if (this->image_->decode_task_handle_ != nullptr) {
+    // The task is not watched by the task watchdog, but it must not starve the idle task.
+    uint32_t now = millis();
+    if (now - this->last_yield_ms_ > 100) {
+      vTaskDelay(1);
+      this->last_yield_ms_ = now;
     }
+    return;
   }
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  App.feed_wdt();
 }
 
 DownloadBuffer::DownloadBuffer(size_t size) : size_(size) {
@@ -35,38 +77,75 @@ DownloadBuffer::DownloadBuffer(size_t size) : size_(size) {
 }
 
 uint8_t *DownloadBuffer::data(size_t offset) {
-  if (offset > this->size_) {
+  if (this->start_ + offset > this->size_) {
     ESP_LOGE(TAG, "Tried to access beyond download buffer bounds!!!");
     return this->buffer_;
   }
-  return this->buffer_ + offset;
+  return this->buffer_ + this->start_ + offset;
+}
+
+size_t DownloadBuffer::free_capacity() {
+  size_t tail = this->size_ - this->start_ - this->unread_;
+  if (this->start_ > 0 && tail < (this->size_ - this->unread_) / 2) {
+    this->compact_();
+    tail = this->size_ - this->unread_;
+  }
+  return tail;
 }
 
 size_t DownloadBuffer::read(size_t len) {
   this->unread_ -= len;
   if (this->unread_ > 0) {
-    memmove(this->data(), this->data(len), this->unread_);
+    this->start_ += len;
+  } else {
+    // Nothing left to keep; start over at the beginning for free.
+    this->start_ = 0;
   }
   return this->unread_;
 }
 
+void DownloadBuffer::compact_() {
+  if (this->start_ == 0) {
+    return;
+  }
+  memmove(this->buffer_, this->buffer_ + this->start_, this->unread_);
+  this->bytes_copied_ += this->unread_;
+  this->start_ = 0;
+}
+
 size_t DownloadBuffer::resize(size_t size) {
   if (this->size_ >= size) {
     // Avoid useless reallocations; if the buffer is big enough, don't reallocate.
     return this->size_;
   }
-  this->allocator_.deallocate(this->buffer_, this->size_);
-  this->buffer_ = this->allocator_.allocate(size);
-  this->reset();
-  if (this->buffer_) {
-    this->size_ = size;
-    return size;
-  } else {
+  // Keep the unread data; the decoder may already have seen part of it.
+  this->compact_();
+  uint8_t *buffer = this->allocator_.reallocate(this->buffer_, size);
+  if (buffer == nullptr) {
+    // The old buffer is still valid and keeps its contents.
     ESP_LOGE(TAG, "allocation of %zu bytes failed. Biggest block in heap: %zu Bytes", size,
              this->allocator_.get_max_free_block_size());
-    this->size_ = 0;
     return 0;
   }
+  this->buffer_ = buffer;
+  this->size_ = size;
+  return size;
+}
+
+uint8_t *DownloadBuffer::release(size_t size, size_t *capacity) {
+  uint8_t *buffer = this->allocator_.allocate(size);
+  if (buffer == nullptr) {
+    ESP_LOGE(TAG, "allocation of %zu bytes failed. Biggest block in heap: %zu Bytes", size,
+             this->allocator_.get_max_free_block_size());
+    return nullptr;
+  }
+  this->compact_();
+  uint8_t *released = this->buffer_;
+  *capacity = this->size_;
+  this->buffer_ = buffer;
+  this->size_ = size;
+  this->unread_ = 0;
+  return released;
 }
 
 }  // namespace online_image
@@ -1,6 +1,8 @@
 #pragma once
 #include "esphome/core/color.h"
 
+#include "resampler.h"
+
 namespace esphome {
 namespace online_image {
 
@@ -10,6 +12,9 @@ enum DecodeError : int {
   DECODE_ERROR_OUT_OF_MEMORY = -3,
 };
 
+/** Download size passed to {@see ImageDecoder::prepare} when the server did not send a Content-Length. */
+static const size_t DOWNLOAD_SIZE_UNKNOWN = SIZE_MAX;
+
 class OnlineImage;
 
 /**
@@ -22,13 +27,14 @@ class ImageDecoder {
    *
    * @param image The image to decode the stream into.
    */
-  ImageDecoder(OnlineImage *image) : image_(image) {}
+  ImageDecoder(OnlineImage *image) : image_(image), resampler_(image) {}
   virtual ~ImageDecoder() = default;
 
   /**
    * @brief Initialize the decoder.
    *
-   * @param download_size The total number of bytes that need to be downloaded for the image.
+   * @param download_size The total number of bytes that need to be downloaded for the image,
+   *                      or DOWNLOAD_SIZE_UNKNOWN for chunked responses.
    * @return int          Returns 0 on success, a {@see DecodeError} value in case of an error.
    */
   virtual int prepare(size_t download_size) {
@@ -64,6 +70,8 @@ class ImageDecoder {
    * @brief Fill a rectangle on the display_buffer using the defined color.
    * Will check the given coordinates for out-of-bounds, and clip the rectangle accordingly.
    * In case of binary displays, the color will be converted to binary as well.
+   * The coordinates are those of the decoded image; they are scaled to the image buffer
+   * by the {@see Resampler}.
    * Called by the callback functions, to be able to access the parent Image class.
    *
    * @param x The left-most coordinate of the rectangle.
@@ -75,31 +83,124 @@ class ImageDecoder {
    */
   void draw(int x, int y, int w, int h, const Color &color, int frame = 0);
 
+  /**
+   * @brief Whether decoded pixels can be written straight into the image buffer with {@see store_pixels},
+   * which is the case when the image is stored unscaled, without viewport or indexed colors.
+   * Otherwise, pixels must go through {@see draw}.
+   */
+  bool can_store_pixels() const;
+
+  /**
+   * @brief Convert consecutive pixels of a row of the first frame into the storage format of the
+   * image buffer, and write them there. Only allowed if {@see can_store_pixels}.
+   *
+   * @param x The left-most coordinate.
+   * @param y The row to write to.
+   * @param colors The colors to store.
+   * @param count The number of colors.
+   */
+  void store_pixels(int x, int y, const Color *colors, int count);
+
+  /**
+   * @brief Copy a decoded frame of the image buffer into another frame.
+   * Used by animated formats whose frames only update part of the previous one.
+   *
+   * @param source The frame to copy.
+   * @param target The frame to overwrite.
+   */
+  void copy_frame(int source, int target);
+
+  /**
+   * @brief Set how long a decoded frame is shown when the animation plays.
+   * Must be called after {@see set_size}, which forgets the durations of the previous image.
+   *
+   * @param frame The frame, as numbered in the file.
+   * @param duration_ms The display time in milliseconds; 0 if the file does not say.
+   */
+  void set_frame_duration(int frame, uint32_t duration_ms);
+
+  /**
+   * @brief Draw a frame into the image buffer, for decoders keeping the encoded image
+   * to decode animation frames only when they are shown.
+   *
+   * @return false if the frame could not be drawn.
+   */
+  virtual bool render_frame(int frame) { return false; }
+
+  /** Number of frames that are drawn on demand by {@see render_frame}, or 0 if all frames are in the buffer. */
+  virtual int get_on_demand_frames() const { return 0; }
+
+  /** Memory kept by the decoder after decoding, to draw frames on demand. */
+  virtual size_t get_retained_size() const { return 0; }
+
   bool is_finished() const { return this->decoded_bytes_ == this->download_size_; }
 
+  /**
+   * @brief Whether the image is drawn row by row, top to bottom, each row being complete
+   * once the next one is started. Partially decoded images can then be shown.
+   */
+  virtual bool is_progressive() const { return false; }
+
+  /**
+   * @brief Whether frames can be left out when memory is short. Not the case for decoders
+   * building frames on top of earlier ones in the image buffer.
+   */
+  virtual bool can_drop_frames() const { return true; }
+
+  /**
+   * @brief Set the total size of a download of unknown length, once the end of the stream is reached.
+   * Decoders that need the whole file can only start decoding after that.
+   */
+  void set_download_size(size_t download_size) { this->download_size_ = download_size; }
+
+  /**
+   * @brief Keep the watchdog happy during long decodes.
+   * On the main loop this feeds the watchdog; in the background decode task it briefly
+   * yields so that lower priority tasks can run.
+   */
+  void feed_wdt();
+
  protected:
+  /**
+   * @brief Whether the decoder draws single pixels from left to right and top to bottom.
+   * Only then can the image be smoothly resampled while decoding.
+   */
+  virtual bool draws_in_raster_order_() const { return true; }
+
   OnlineImage *image_;
+  Resampler resampler_;
   // Initializing to 1, to ensure it is distinguishable from initial "decoded_bytes_".
   // Will be overwritten anyway once the download size is known.
   size_t download_size_ = 1;
   size_t decoded_bytes_ = 0;
-  double x_scale_ = 1.0;
-  double y_scale_ = 1.0;
+  uint32_t last_yield_ms_ = 0;
 };
 
+/**
+ * @brief Buffer for the downloaded data not yet consumed by the decoder.
+ *
+ * Reading only moves the start of the unread data forward. The unread data is moved back
+ * to the beginning of the buffer only when the space left at the end gets too small, so
+ * that decoders always see a contiguous block without copying on every read.
+ */
 class DownloadBuffer {
  public:
   DownloadBuffer(size_t size);
 
   virtual ~DownloadBuffer() { this->allocator_.deallocate(this->buffer_, this->size_); }
 
+  /** Pointer to the unread data, at the given offset. */
   uint8_t *data(size_t offset = 0);
 
   uint8_t *append() { return this->data(this->unread_); }
 
   size_t unread() const { return this->unread_; }
   size_t size() const { return this->size_; }
-  size_t free_capacity() const { return this->size_ - this->unread_; }
+  /**
+   * @brief Contiguous space available after the unread data.
+   * Compacts the buffer first if too much of the free space is in front of the unread data.
+   */
+  size_t free_capacity();
 
   size_t read(size_t len);
   size_t write(size_t len) {
@@ -107,16 +208,39 @@ class DownloadBuffer {
     return this->unread_;
   }
 
-  void reset() { this->unread_ = 0; }
+  void reset() {
+    this->start_ = 0;
+    this->unread_ = 0;
+    this->bytes_copied_ = 0;
+  }
 
   size_t resize(size_t size);
 
+  /**
+   * @brief Hand over the memory holding the unread data, which starts at the returned pointer,
+   * and continue with a new empty buffer.
+   *
+   * @param size Size of the new buffer.
+   * @param capacity Set to the size of the returned allocation.
+   * @return The old buffer, or nullptr if the new one could not be allocated.
+   */
+  uint8_t *release(size_t size, size_t *capacity);
+
+  /** Number of bytes moved while compacting since the last reset. */
+  size_t get_bytes_copied() const { return this->bytes_copied_; }
+
  protected:
+  /** Move the unread data to the beginning of the buffer. */
+  void compact_();
+
   RAMAllocator<uint8_t> allocator_{};
   uint8_t *buffer_;
   size_t size_;
+  /** Offset of the first unread byte. */
+  size_t start_;
   /** Total number of downloaded bytes not yet read. */
   size_t unread_;
+  size_t bytes_copied_;
 };
 
 }  // namespace online_image
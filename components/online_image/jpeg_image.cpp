@@ -2,7 +2,6 @@
 #ifdef USE_ONLINE_IMAGE_JPEG_SUPPORT
 
 #include "esphome/components/display/display_buffer.h"
-#include "esphome/core/application.h"
 #include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 
@@ -20,21 +19,20 @@ namespace online_image {
  */
 static int draw_callback(JPEGDRAW *jpeg) {
   ImageDecoder *decoder = (ImageDecoder *) jpeg->pUser;
+  if (!decoder) {
+    ESP_LOGE(TAG, "Decoder pointer is null!");
+    return 0;
+  }
 
   // Some very big images take too long to decode, so feed the watchdog on each callback
   // to avoid crashing.
-  App.feed_wdt();
+  decoder->feed_wdt();
   size_t position = 0;
   for (size_t y = 0; y < jpeg->iHeight; y++) {
     for (size_t x = 0; x < jpeg->iWidth; x++) {
       auto rg = decode_value(jpeg->pPixels[position++]);
       auto ba = decode_value(jpeg->pPixels[position++]);
       Color color(rg[1], rg[0], ba[1], ba[0]);
-
-      if (!decoder) {
-        ESP_LOGE(TAG, "Decoder pointer is null!");
-        return 0;
-      }
       decoder->draw(jpeg->x + x, jpeg->y + y, 1, 1, color);
     }
   }
@@ -43,6 +41,10 @@ static int draw_callback(JPEGDRAW *jpeg) {
 
 int JpegDecoder::prepare(size_t download_size) {
   ImageDecoder::prepare(download_size);
+  if (download_size == DOWNLOAD_SIZE_UNKNOWN) {
+    // The download buffer grows while the image is being downloaded.
+    return 0;
+  }
   auto size = this->image_->resize_download_buffer(download_size);
   if (size < download_size) {
     ESP_LOGE(TAG, "Download buffer resize failed!");
@@ -53,7 +55,7 @@ int JpegDecoder::prepare(size_t download_size) {
 
 int HOT JpegDecoder::decode(uint8_t *buffer, size_t size) {
   if (size < this->download_size_) {
-    ESP_LOGV(TAG, "Download not complete. Size: %d/%d", size, this->download_size_);
+    ESP_LOGV(TAG, "Download not complete. Size: %zu/%zu", size, this->download_size_);
     return 0;
   }
 
@@ -25,6 +25,9 @@ class JpegDecoder : public ImageDecoder {
   int HOT decode(uint8_t *buffer, size_t size) override;
 
  protected:
+  // JPEGDEC draws blocks of MCUs, not whole rows.
+  bool draws_in_raster_order_() const override { return false; }
+
   JPEGDEC jpeg_{};
 };
 
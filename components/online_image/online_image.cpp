@@ -1,9 +1,33 @@
 #include "online_image.h"
 
+#include "esphome/core/hal.h"
 #include "esphome/core/log.h"
 
+#include <cinttypes>
+
 static const char *const TAG = "online_image";
 
+static const char *const ETAG_HEADER_NAME = "etag";
+static const char *const IF_NONE_MATCH_HEADER_NAME = "If-None-Match";
+static const char *const LAST_MODIFIED_HEADER_NAME = "last-modified";
+static const char *const IF_MODIFIED_SINCE_HEADER_NAME = "If-Modified-Since";
+static const char *const CONTENT_TYPE_HEADER_NAME = "content-type";
+static const char *const CONTENT_RANGE_HEADER_NAME = "content-range";
+static const char *const RANGE_HEADER_NAME = "Range";
+static const char *const IF_RANGE_HEADER_NAME = "If-Range";
+
+/** Smallest fraction of the requested width and height the image is shrunk to when memory is short. */
+static const int MAX_DOWNSCALE = 4;
+/** Display time of frames without a usable duration. */
+static const uint32_t DEFAULT_FRAME_DURATION_MS = 100;
+/** Shorter durations are taken as unset, like browsers do. */
+static const uint32_t MIN_FRAME_DURATION_MS = 20;
+
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+// Stack size for the decode task (HTTP client with TLS, plus the image decoders)
+static const uint32_t DECODE_TASK_STACK_SIZE = 12288;
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
+
 #include "image_decoder.h"
 
 #ifdef USE_ONLINE_IMAGE_BMP_SUPPORT
@@ -18,6 +42,12 @@ static const char *const TAG = "online_image";
 #ifdef USE_ONLINE_IMAGE_PNG_SUPPORT
 #include "png_image.h"
 #endif
+#ifdef USE_ONLINE_IMAGE_QOI_SUPPORT
+#include "qoi_image.h"
+#endif
+#ifdef USE_ONLINE_IMAGE_GIF_SUPPORT
+#include "gif_image.h"
+#endif
 
 namespace esphome {
 namespace online_image {
@@ -46,68 +76,489 @@ OnlineImage::OnlineImage(const std::string &url, int width, int height, ImageFor
 }
 
 void OnlineImage::draw(int x, int y, display::Display *display, Color color_on, Color color_off) {
-  if (this->data_start_) {
-    Image::draw(x, y, display, color_on, color_off);
+  if ((this->front_.buffer || !this->is_decoding_in_background_()) && this->data_start_) {
+    if (this->front_.buffer) {
+      if (this->front_.frame_store) {
+        this->restore_frame_(this->front_.frame_store.get(), this->front_.buffer, this->front_.stored_frame);
+      } else if (this->front_.frame_source) {
+        // The frame source draws into the buffer being decoded; keep showing the last frame.
+        this->data_start_ = this->front_.buffer;
+      }
+    } else if (this->frame_store_) {
+      this->restore_frame_(this->frame_store_.get(), this->buffer_, this->stored_frame_);
+    } else if (this->frame_source_) {
+      this->show_frame_();
+    }
+    const Palette *palette = this->front_.buffer ? this->front_.palette.get() : this->palette_.get();
+    if (palette) {
+      this->draw_indexed_(x, y, display, *palette);
+    } else if (!this->blit_(x, y, display)) {
+      Image::draw(x, y, display, color_on, color_off);
+    }
   } else if (this->placeholder_) {
     this->placeholder_->draw(x, y, display, color_on, color_off);
   }
 }
 
-void OnlineImage::release() {
+bool OnlineImage::clip_(int x, int y, display::Display *display, int &x1, int &y1, int &x2, int &y2) const {
+  // Drivers only take their fast path if the whole area is visible, so clip it here.
+  x1 = std::max(x, 0);
+  y1 = std::max(y, 0);
+  x2 = std::min(x + this->width_, display->get_width());
+  y2 = std::min(y + this->height_, display->get_height());
+  if (display->is_clipping()) {
+    display::Rect clip = display->get_clipping();
+    x1 = std::max<int>(x1, clip.x);
+    y1 = std::max<int>(y1, clip.y);
+    x2 = std::min<int>(x2, clip.x2());
+    y2 = std::min<int>(y2, clip.y2());
+  }
+  return x1 < x2 && y1 < y2;
+}
+
+bool OnlineImage::blit_(int x, int y, display::Display *display) {
+  if (this->transparency_ != image::TRANSPARENCY_OPAQUE) {
+    return false;
+  }
+  display::ColorBitness bitness;
+  switch (this->type_) {
+    case ImageType::IMAGE_TYPE_RGB565:
+      bitness = display::COLOR_BITNESS_565;
+      break;
+    case ImageType::IMAGE_TYPE_RGB:
+      bitness = display::COLOR_BITNESS_888;
+      break;
+    default:
+      return false;
+  }
+  int x1, y1, x2, y2;
+  if (this->clip_(x, y, display, x1, y1, x2, y2)) {
+    // RGB565 is stored big endian, RGB as R, G, B bytes.
+    display->draw_pixels_at(x1, y1, x2 - x1, y2 - y1, this->data_start_, display::COLOR_ORDER_RGB, bitness, true,
+                            x1 - x, y1 - y, x + this->width_ - x2);
+  }
+  return true;
+}
+
+void OnlineImage::draw_indexed_(int x, int y, display::Display *display, const Palette &palette) {
+  const uint8_t *data = this->data_start_;
+  bool raw_frames = this->front_.buffer ? !this->front_.frame_store && !this->front_.frame_source
+                                        : !this->frame_store_ && !this->frame_source_;
+  if (raw_frames) {
+    // The animation steps through the buffer by the stride of the image type; indexed frames are smaller.
+    data = this->animation_data_start_ + this->current_frame_ * this->width_ * this->height_;
+  }
+  int x1, y1, x2, y2;
+  if (!this->clip_(x, y, display, x1, y1, x2, y2)) {
+    return;
+  }
+  // Each visible row is expanded to RGB, and drawn in runs of opaque pixels.
+  this->indexed_row_.resize((x2 - x1) * 3);
+  uint8_t *rgb = this->indexed_row_.data();
+  for (int img_y = y1 - y; img_y < y2 - y; img_y++) {
+    const uint8_t *row = data + img_y * this->width_;
+    int run = -1;
+    for (int img_x = x1 - x; img_x <= x2 - x; img_x++) {
+      const Color *color = img_x < x2 - x ? &palette.get_color(row[img_x]) : nullptr;
+      if (color && color->w >= 0x80) {
+        uint8_t *p = rgb + (img_x - (x1 - x)) * 3;
+        p[0] = color->r;
+        p[1] = color->g;
+        p[2] = color->b;
+        if (run < 0) {
+          run = img_x;
+        }
+      } else if (run >= 0) {
+        display->draw_pixels_at(x + run, y + img_y, img_x - run, 1, rgb, display::COLOR_ORDER_RGB,
+                                display::COLOR_BITNESS_888, true, run - (x1 - x), 0, (x2 - x) - img_x);
+        run = -1;
+      }
+    }
+  }
+}
+
+void OnlineImage::set_url(const std::string &url) {
+  if (!this->validate_url_(url)) {
+    return;
+  }
+  // A running download owns the buffer; the image it produces is cached on the next URL change.
+  if (this->cache_ && url != this->url_ && !this->is_downloading_()) {
+    this->cache_image_();
+    this->load_cached_image_(url);
+  }
+  this->url_ = url;
+}
+
+void OnlineImage::set_viewport(int x, int y) {
+  bool changed = !this->viewport_ || x != this->viewport_x_ || y != this->viewport_y_;
+  this->viewport_ = true;
+  this->viewport_x_ = x;
+  this->viewport_y_ = y;
+  // A running download is checked against the viewport once it finishes.
+  if (changed && !this->is_downloading_()) {
+    // Other pixels are needed, even if the image did not change on the server.
+    this->clear_validators_();
+    if (this->cache_) {
+      this->cache_->clear();
+    }
+  }
+}
+
+bool OnlineImage::is_decoding_in_background_() const {
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  return this->task_status_.load() != DOWNLOAD_IDLE;
+#else
+  return false;
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
+}
+
+bool OnlineImage::is_downloading_() const {
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  if (this->task_status_.load() != DOWNLOAD_IDLE) {
+    return true;
+  }
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  return this->decoder_ || this->downloader_;
+}
+
+void OnlineImage::detach_image_(CachedImage &image) {
+  image.url = this->validators_url_;
+  image.buffer = this->buffer_;
+  image.buffer_size = this->get_allocated_size_();
+  image.width = this->buffer_width_;
+  image.height = this->buffer_height_;
+  image.frame_count = this->buffer_frame_count_;
+  image.frame_size = this->buffer_frame_size_;
+  image.degraded = this->buffer_degraded_;
+  image.frame_store = std::move(this->frame_store_);
+  image.frame_source = std::move(this->frame_source_);
+  image.stored_frame = this->stored_frame_;
+  image.palette = std::move(this->palette_);
+  image.frame_durations = std::move(this->frame_durations_);
+  this->frame_durations_.clear();
+  image.etag = this->etag_;
+  image.last_modified = this->last_modified_;
+  image.fetched_ms = this->fetched_ms_;
+
+  this->buffer_ = nullptr;
+  this->buffer_width_ = 0;
+  this->buffer_height_ = 0;
+  this->buffer_frame_count_ = 0;
+  this->buffer_frame_size_ = 0;
+  this->buffer_degraded_ = false;
+}
+
+void OnlineImage::attach_image_(CachedImage &image) {
   if (this->buffer_) {
-    ESP_LOGV(TAG, "Deallocating old buffer...");
-    this->allocator_.deallocate(this->buffer_, this->get_buffer_size_());
-    this->data_start_ = nullptr;
-    this->buffer_ = nullptr;
-    this->width_ = 0;
-    this->height_ = 0;
-    this->buffer_width_ = 0;
-    this->buffer_height_ = 0;
-    this->buffer_frame_size_ = 0;
+    this->free_buffer_();
+  }
+  this->buffer_ = image.buffer;
+  this->buffer_width_ = image.width;
+  this->buffer_height_ = image.height;
+  this->buffer_frame_count_ = image.frame_count;
+  this->buffer_frame_size_ = image.frame_size;
+  this->buffer_degraded_ = image.degraded;
+  this->frame_store_ = std::move(image.frame_store);
+  this->frame_source_ = std::move(image.frame_source);
+  this->stored_frame_ = image.stored_frame;
+  this->palette_ = std::move(image.palette);
+  this->frame_durations_ = std::move(image.frame_durations);
+  image.frame_durations.clear();
+  this->etag_ = image.etag;
+  this->last_modified_ = image.last_modified;
+  this->validators_url_ = image.url;
+  this->fetched_ms_ = image.fetched_ms;
+  image.buffer = nullptr;
+  this->publish_image_();
+}
+
+void OnlineImage::publish_image_() {
+  this->data_start_ = this->buffer_;
+  this->animation_data_start_ = this->buffer_;
+  this->width_ = this->buffer_width_;
+  this->height_ = this->buffer_height_;
+  this->animation_frame_count_ = this->buffer_frame_count_;
+  this->current_frame_ = 0;
+  this->played_frame_ = 0;
+  this->played_frame_ms_ = millis();
+}
+
+void OnlineImage::cache_image_() {
+  // The validators are only kept for a fully decoded image.
+  if (!this->buffer_ || this->validators_url_.empty()) {
+    return;
+  }
+  CachedImage image;
+  this->detach_image_(image);
+  this->data_start_ = nullptr;
+  this->animation_data_start_ = nullptr;
+  this->width_ = 0;
+  this->height_ = 0;
+  this->clear_validators_();
+  this->cache_->put(std::move(image));
+}
+
+void OnlineImage::load_cached_image_(const std::string &url) {
+  CachedImage image;
+  if (this->cache_->take(url, image)) {
+    this->attach_image_(image);
+  }
+}
+
+void OnlineImage::hold_front_image_() {
+  if (!this->double_buffer_ || !this->data_start_ || this->front_.buffer) {
+    return;
+  }
+  // Keep the validators, so that an unchanged image is not downloaded again.
+  this->detach_image_(this->front_);
+  ESP_LOGV(TAG, "Keeping %zu bytes on screen while decoding", this->front_.memory());
+}
+
+void OnlineImage::free_front_image_() {
+  if (!this->front_.buffer) {
+    return;
+  }
+  this->allocator_.deallocate(this->front_.buffer, this->front_.buffer_size);
+  this->front_.buffer = nullptr;
+  this->front_.frame_store.reset();
+  this->front_.frame_source.reset();
+  this->front_.palette.reset();
+  this->front_.frame_durations.clear();
+  this->data_start_ = nullptr;
+  this->animation_data_start_ = nullptr;
+  this->width_ = 0;
+  this->height_ = 0;
+}
+
+void OnlineImage::release() {
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  if (this->task_status_.load() != DOWNLOAD_IDLE) {
+    // The decode task owns the buffer until it is done; release once the image has been handed over.
+    this->release_pending_ = true;
+    return;
+  }
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  if (this->buffer_ || this->front_.buffer) {
+    this->free_front_image_();
+    if (this->buffer_) {
+      this->free_buffer_();
+    }
     this->end_connection_();
   }
+  this->resume_offset_ = 0;
+  this->clear_validators_();
+}
+
+void OnlineImage::clear_validators_() {
+  this->etag_ = "";
+  this->last_modified_ = "";
+  this->validators_url_ = "";
+}
+
+void OnlineImage::free_buffer_() {
+  ESP_LOGV(TAG, "Deallocating old buffer...");
+  if (this->frame_store_) {
+    this->release_frame_store_();
+  } else {
+    this->allocator_.deallocate(this->buffer_, this->get_allocated_size_());
+  }
+  this->frame_source_.reset();
+  this->palette_.reset();
+  this->frame_durations_.clear();
+  this->data_start_ = nullptr;
+  this->buffer_ = nullptr;
+  this->buffer_degraded_ = false;
+  this->width_ = 0;
+  this->height_ = 0;
+  this->buffer_width_ = 0;
+  this->buffer_height_ = 0;
+  this->buffer_frame_size_ = 0;
 }
 
 size_t OnlineImage::resize_(int width_in, int height_in, int frames) {
+  // Set again by the decoder for the new image
+  this->frame_durations_.clear();
   int width = this->fixed_width_;
   int height = this->fixed_height_;
   if (this->is_auto_resize_()) {
     width = width_in;
     height = height_in;
-    if (this->width_ != width && this->height_ != height) {
-      this->release();
+    if (this->buffer_ &&
+        (this->buffer_width_ != width || this->buffer_height_ != height || this->buffer_frame_count_ != frames)) {
+      // Only free the buffer; the download in progress must go on.
+      this->free_buffer_();
     }
   }
-  size_t new_size = this->get_buffer_size_(width, height, frames);
+  if (this->frame_store_ || this->frame_source_) {
+    // The buffer only holds a single frame; a full buffer is needed for decoding.
+    this->free_buffer_();
+  }
+  if (this->buffer_degraded_) {
+    // Memory may have been freed since; try the full image again.
+    this->free_buffer_();
+  }
   if (this->buffer_) {
     // Buffer already allocated => no need to resize
-    return new_size;
-  }
-  ESP_LOGD(TAG, "Allocating new buffer of %zu bytes", new_size);
-  this->buffer_ = this->allocator_.allocate(new_size);
-  if (this->buffer_ == nullptr) {
-    ESP_LOGE(TAG, "allocation of %zu bytes failed. Biggest block in heap: %zu Bytes", new_size,
-             this->allocator_.get_max_free_block_size());
-    this->end_connection_();
+    this->buffer_frame_step_ = 1;
+    if (this->palette_) {
+      // A new image is being decoded; collect its colors from scratch.
+      this->palette_->reset(this->has_transparency());
+    }
+  } else if (!this->allocate_buffer_(width, height, frames)) {
+    // The decoder reports the failure; the connection is closed once it returns.
     return 0;
   }
-  this->buffer_width_ = width;
-  this->buffer_height_ = height;
-  this->width_ = width;
-  this->animation_frame_count_ = frames;
-  this->buffer_frame_size_ = new_size / frames;
-  this->current_frame_ = 0;
-  ESP_LOGV(TAG, "New size: (%d, %d, %d)", width, height, frames);
-  return new_size;
+  if (this->viewport_) {
+    this->buffer_x_ = this->viewport_x_;
+    this->buffer_y_ = this->viewport_y_;
+    if (this->buffer_x_ + this->buffer_width_ > width_in || this->buffer_y_ + this->buffer_height_ > height_in) {
+      // Part of the viewport is outside of the image, and is never drawn; leave it empty.
+      memset(this->buffer_, 0, this->get_buffer_size_());
+      if (this->palette_) {
+        // Make entry 0 transparent, or black.
+        this->palette_->get_index(Color(0, 0, 0, 0));
+      }
+    }
+  }
+  return this->get_buffer_size_();
+}
+
+bool OnlineImage::allocate_buffer_(int width, int height, int frames) {
+  const bool can_index =
+      !this->indexed_ && (this->type_ == ImageType::IMAGE_TYPE_RGB || this->type_ == ImageType::IMAGE_TYPE_RGB565);
+  const bool can_drop_frames = frames > 1 && this->decoder_ && this->decoder_->can_drop_frames();
+  bool indexed = this->indexed_;
+  int scale = 1;
+  int step = 1;
+  while (true) {
+    int buffer_width = std::max(width / scale, 1);
+    int buffer_height = std::max(height / scale, 1);
+    int frame_size = get_frame_size_(buffer_width, buffer_height, indexed ? 8 : this->get_bpp());
+    int kept_frames = (frames + step - 1) / step;
+    size_t size = static_cast<size_t>(frame_size) * kept_frames;
+    ESP_LOGD(TAG, "Allocating new buffer of %zu bytes", size);
+    this->buffer_ = this->allocator_.allocate(size);
+    if (this->buffer_) {
+      this->buffer_width_ = buffer_width;
+      this->buffer_height_ = buffer_height;
+      this->buffer_frame_count_ = kept_frames;
+      this->buffer_frame_size_ = frame_size;
+      this->buffer_frame_step_ = step;
+      this->buffer_degraded_ = indexed != this->indexed_ || step > 1 || scale > 1;
+      if (indexed) {
+        if (!this->palette_) {
+          this->palette_ = make_unique<Palette>();
+        }
+        this->palette_->reset(this->has_transparency());
+      } else {
+        this->palette_.reset();
+      }
+      if (this->buffer_degraded_) {
+        ESP_LOGW(TAG, "Not enough memory for the full image; keeping %d of %d frames at %dx%d%s", kept_frames,
+                 frames, buffer_width, buffer_height, indexed != this->indexed_ ? " with indexed colors" : "");
+      }
+      ESP_LOGV(TAG, "New size: (%d, %d, %d)", buffer_width, buffer_height, kept_frames);
+      return true;
+    }
+    size_t max_block = this->allocator_.get_max_free_block_size();
+    ESP_LOGW(TAG, "allocation of %zu bytes failed. Biggest block in heap: %zu Bytes", size, max_block);
+
+    // Drop frames first, then pixels. Indexed colors come last: the palette is built from the
+    // first colors decoded, which posterizes photos.
+    if (can_drop_frames && kept_frames > 1) {
+      // Keep evenly spaced frames, as many as fit in the biggest free block.
+      int fitting_frames = max_block / frame_size;
+      step = std::max(step + 1, fitting_frames > 0 ? (frames + fitting_frames - 1) / fitting_frames : frames);
+    } else if (scale < MAX_DOWNSCALE && (buffer_width > 1 || buffer_height > 1)) {
+      scale *= 2;
+      step = 1;
+    } else if (can_index && !indexed) {
+      indexed = true;
+      step = 1;
+    } else {
+      ESP_LOGE(TAG, "Could not allocate memory for the image, even degraded");
+      return false;
+    }
+  }
+}
+
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+void OnlineImage::setup() {
+  if (!this->background_decode_) {
+    return;
+  }
+  BaseType_t result = xTaskCreatePinnedToCore(OnlineImage::decode_task,      // Task function
+                                              "online_image",                // Task name
+                                              DECODE_TASK_STACK_SIZE,        // Stack size
+                                              this,                          // Parameter (this pointer)
+                                              1,                             // Priority (low, background task)
+                                              &this->decode_task_handle_,    // Task handle
+                                              1                              // Core 1 (keep core 0 for main loop)
+  );
+  if (result != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create decode task; decoding on the main loop");
+    this->decode_task_handle_ = nullptr;
+  }
 }
 
+// Background decode task - downloads and decodes the image, then hands it over to the main loop
+void OnlineImage::decode_task(void *arg) {
+  OnlineImage *self = static_cast<OnlineImage *>(arg);
+  while (true) {
+    // Wait for update() to request a download
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    DownloadStatus status = self->start_download_(self->task_url_);
+    while (status == DOWNLOAD_IN_PROGRESS) {
+      status = self->download_step_();
+      if (self->decoder_) {
+        self->decoder_->feed_wdt();
+      }
+    }
+    // Everything written by the task so far becomes visible to the main loop with this store
+    self->task_status_.store(status);
+  }
+}
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
+
 void OnlineImage::update() {
-  if (this->decoder_) {
+  if (this->cache_ && this->buffer_ && this->validators_url_ == this->url_ && !this->is_downloading_() &&
+      millis() - this->fetched_ms_ < this->cache_->get_max_age()) {
+    ESP_LOGD(TAG, "Image %s is still fresh", this->url_.c_str());
+    return;
+  }
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  if (this->decode_task_handle_ != nullptr) {
+    if (this->task_status_.load() != DOWNLOAD_IDLE) {
+      ESP_LOGW(TAG, "Image already being updated.");
+      return;
+    }
+    ESP_LOGI(TAG, "Updating image %s in the background", this->url_.c_str());
+    this->hold_front_image_();
+    if (!this->front_.buffer) {
+      // The task decodes into the buffer, or reallocates it; stop drawing from it until the new
+      // image is published.
+      this->data_start_ = nullptr;
+    }
+    this->task_url_ = this->url_;
+    this->task_status_.store(DOWNLOAD_IN_PROGRESS);
+    xTaskNotifyGive(this->decode_task_handle_);
+    return;
+  }
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  if (this->decoder_ || this->downloader_) {
     ESP_LOGW(TAG, "Image already being updated.");
     return;
   }
   ESP_LOGI(TAG, "Updating image %s", this->url_.c_str());
+  this->hold_front_image_();
+  auto status = this->start_download_(this->url_);
+  if (status != DOWNLOAD_IN_PROGRESS) {
+    this->finish_download_(status);
+  }
+}
 
+DownloadStatus OnlineImage::start_download_(const std::string &url) {
+  this->connection_lost_ = false;
   std::list<http_request::Header> headers = {};
 
   http_request::Header accept_header;
@@ -134,6 +585,38 @@ void OnlineImage::update() {
       accept_mime_type = "image/png";
       break;
 #endif  // ONLINE_IMAGE_PNG_SUPPORT
+#ifdef USE_ONLINE_IMAGE_QOI_SUPPORT
+    case ImageFormat::QOI:
+      accept_mime_type = "image/qoi";
+      break;
+#endif  // USE_ONLINE_IMAGE_QOI_SUPPORT
+#ifdef USE_ONLINE_IMAGE_GIF_SUPPORT
+    case ImageFormat::GIF:
+      accept_mime_type = "image/gif";
+      break;
+#endif  // USE_ONLINE_IMAGE_GIF_SUPPORT
+    case ImageFormat::AUTO:
+      // Prefer the formats that can be decoded
+#ifdef USE_ONLINE_IMAGE_BMP_SUPPORT
+      accept_mime_type += "image/bmp,";
+#endif  // ONLINE_IMAGE_BMP_SUPPORT
+#ifdef USE_ONLINE_IMAGE_JPEG_SUPPORT
+      accept_mime_type += "image/jpeg,";
+#endif  // USE_ONLINE_IMAGE_JPEG_SUPPORT
+#ifdef USE_ONLINE_IMAGE_WEBP_SUPPORT
+      accept_mime_type += "image/webp,";
+#endif  // USE_ONLINE_IMAGE_WEBP_SUPPORT
+#ifdef USE_ONLINE_IMAGE_PNG_SUPPORT
+      accept_mime_type += "image/png,";
+#endif  // ONLINE_IMAGE_PNG_SUPPORT
+#ifdef USE_ONLINE_IMAGE_QOI_SUPPORT
+      accept_mime_type += "image/qoi,";
+#endif  // USE_ONLINE_IMAGE_QOI_SUPPORT
+#ifdef USE_ONLINE_IMAGE_GIF_SUPPORT
+      accept_mime_type += "image/gif,";
+#endif  // USE_ONLINE_IMAGE_GIF_SUPPORT
+      accept_mime_type += "image/*;q=0.9";
+      break;
     default:
       accept_mime_type = "image/*";
   }
@@ -141,111 +624,471 @@ void OnlineImage::update() {
 
   headers.push_back(accept_header);
 
-  this->downloader_ = this->parent_->get(this->url_, headers);
+  bool resume = this->resume_offset_ > 0 && this->resume_url_ == url;
+  if (!resume && this->resume_offset_ > 0) {
+    // The interrupted download was for another image.
+    this->resume_offset_ = 0;
+    this->download_buffer_.reset();
+  }
+  if (resume) {
+    // Only the missing bytes, as long as the image did not change since.
+    headers.push_back(http_request::Header{RANGE_HEADER_NAME, str_sprintf("bytes=%zu-", this->resume_offset_)});
+    headers.push_back(http_request::Header{
+        IF_RANGE_HEADER_NAME, this->resume_etag_.empty() ? this->resume_last_modified_ : this->resume_etag_});
+  } else if ((this->buffer_ || this->front_.buffer) && this->validators_url_ == url) {
+    // Only ask for a 304 if the buffer still holds the image these validators belong to.
+    if (!this->etag_.empty()) {
+      headers.push_back(http_request::Header{IF_NONE_MATCH_HEADER_NAME, this->etag_});
+    }
+    if (!this->last_modified_.empty()) {
+      headers.push_back(http_request::Header{IF_MODIFIED_SINCE_HEADER_NAME, this->last_modified_});
+    }
+  }
+
+  std::set<std::string> collect_headers = {ETAG_HEADER_NAME, LAST_MODIFIED_HEADER_NAME, CONTENT_TYPE_HEADER_NAME,
+                                           CONTENT_RANGE_HEADER_NAME};
+  this->downloader_ = this->parent_->get(url, headers, collect_headers);
 
   if (this->downloader_ == nullptr) {
     ESP_LOGE(TAG, "Download failed.");
-    this->end_connection_();
-    this->download_error_callback_.call();
-    return;
+    return DOWNLOAD_ERROR;
   }
 
   int http_code = this->downloader_->status_code;
   if (http_code == HTTP_CODE_NOT_MODIFIED) {
     // Image hasn't changed on server. Skip download.
-    this->end_connection_();
-    return;
+    return DOWNLOAD_NOT_MODIFIED;
   }
-  if (http_code != HTTP_CODE_OK) {
-    ESP_LOGE(TAG, "HTTP result: %d", http_code);
-    this->end_connection_();
-    this->download_error_callback_.call();
-    return;
+  size_t total_size;
+  if (resume && http_code == HTTP_CODE_PARTIAL_CONTENT) {
+    if (!this->check_content_range_(this->downloader_->get_response_header(CONTENT_RANGE_HEADER_NAME))) {
+      this->resume_offset_ = 0;
+      this->download_buffer_.reset();
+      return DOWNLOAD_ERROR;
+    }
+    ESP_LOGD(TAG, "Resuming download at %zu of %zu bytes", this->resume_offset_, this->resume_size_);
+    this->etag_ = this->resume_etag_;
+    this->last_modified_ = this->resume_last_modified_;
+    total_size = this->resume_size_;
+    this->unknown_length_ = false;
+  } else {
+    if (http_code != HTTP_CODE_OK) {
+      ESP_LOGE(TAG, "HTTP result: %d", http_code);
+      return DOWNLOAD_ERROR;
+    }
+    if (resume) {
+      ESP_LOGD(TAG, "Image changed on the server, or ranges are not supported; downloading it in full");
+      this->resume_offset_ = 0;
+      this->download_buffer_.reset();
+    }
+    this->etag_ = this->downloader_->get_response_header(ETAG_HEADER_NAME);
+    this->last_modified_ = this->downloader_->get_response_header(LAST_MODIFIED_HEADER_NAME);
+
+    ESP_LOGD(TAG, "Starting download");
+    total_size = this->downloader_->content_length;
+    // Chunked responses come without a Content-Length; read until the server closes the stream.
+    this->unknown_length_ = total_size == 0 || total_size == DOWNLOAD_SIZE_UNKNOWN;
+    if (this->unknown_length_) {
+#ifndef USE_ESP_IDF
+      // The Arduino HTTP clients read 0 bytes both while waiting for data and at the end of the
+      // stream; the end of a response without a length can not be told apart from a stall.
+      ESP_LOGE(TAG, "Images sent without a Content-Length are only supported with esp-idf");
+      return DOWNLOAD_ERROR;
+#endif  // USE_ESP_IDF
+      total_size = DOWNLOAD_SIZE_UNKNOWN;
+    }
   }
+  this->validators_url_ = url;
 
-  ESP_LOGD(TAG, "Starting download");
-  size_t total_size = this->downloader_->content_length;
+  this->download_size_ = total_size;
+  if (this->unknown_length_) {
+    ESP_LOGI(TAG, "Downloading image (Size: unknown)");
+  } else {
+    ESP_LOGI(TAG, "Downloading image (Size: %zu)", total_size);
+  }
+  if (this->format_ != ImageFormat::AUTO) {
+    if (!this->create_decoder_(this->format_)) {
+      return DOWNLOAD_ERROR;
+    }
+  } else {
+    // The decoder is chosen once the first bytes of the image have been received.
+    this->content_type_ = this->downloader_->get_response_header(CONTENT_TYPE_HEADER_NAME);
+  }
+  this->start_ms_ = millis();
+  this->decode_us_ = 0;
+  this->pixels_drawn_ = 0;
+  this->progress_row_ = 0;
+  return DOWNLOAD_IN_PROGRESS;
+}
 
+bool OnlineImage::create_decoder_(ImageFormat format) {
 #ifdef USE_ONLINE_IMAGE_BMP_SUPPORT
-  if (this->format_ == ImageFormat::BMP) {
+  if (format == ImageFormat::BMP) {
     ESP_LOGD(TAG, "Allocating BMP decoder");
     this->decoder_ = make_unique<BmpDecoder>(this);
   }
 #endif  // ONLINE_IMAGE_BMP_SUPPORT
 #ifdef USE_ONLINE_IMAGE_JPEG_SUPPORT
-  if (this->format_ == ImageFormat::JPEG) {
+  if (format == ImageFormat::JPEG) {
     ESP_LOGD(TAG, "Allocating JPEG decoder");
     this->decoder_ = esphome::make_unique<JpegDecoder>(this);
   }
 #endif  // USE_ONLINE_IMAGE_JPEG_SUPPORT
 #ifdef USE_ONLINE_IMAGE_WEBP_SUPPORT
-  if (this->format_ == ImageFormat::WEBP) {
+  if (format == ImageFormat::WEBP) {
     ESP_LOGD(TAG, "Allocating WEBP decoder");
     this->decoder_ = esphome::make_unique<WebpDecoder>(this);
   }
 #endif  // USE_ONLINE_IMAGE_WEBP_SUPPORT
 #ifdef USE_ONLINE_IMAGE_PNG_SUPPORT
-  if (this->format_ == ImageFormat::PNG) {
+  if (format == ImageFormat::PNG) {
     ESP_LOGD(TAG, "Allocating PNG decoder");
     this->decoder_ = make_unique<PngDecoder>(this);
   }
 #endif  // ONLINE_IMAGE_PNG_SUPPORT
+#ifdef USE_ONLINE_IMAGE_QOI_SUPPORT
+  if (format == ImageFormat::QOI) {
+    ESP_LOGD(TAG, "Allocating QOI decoder");
+    this->decoder_ = make_unique<QoiDecoder>(this);
+  }
+#endif  // USE_ONLINE_IMAGE_QOI_SUPPORT
+#ifdef USE_ONLINE_IMAGE_GIF_SUPPORT
+  if (format == ImageFormat::GIF) {
+    ESP_LOGD(TAG, "Allocating GIF decoder");
+    this->decoder_ = make_unique<GifDecoder>(this, this->on_demand_frames_);
+  }
+#endif  // USE_ONLINE_IMAGE_GIF_SUPPORT
 
   if (!this->decoder_) {
-    ESP_LOGE(TAG, "Could not instantiate decoder. Image format unsupported: %d", this->format_);
-    this->end_connection_();
-    this->download_error_callback_.call();
-    return;
+    ESP_LOGE(TAG, "Could not instantiate decoder. Image format unsupported: %d", format);
+    return false;
   }
-  auto prepare_result = this->decoder_->prepare(total_size);
+  auto prepare_result = this->decoder_->prepare(this->download_size_);
   if (prepare_result < 0) {
-    this->end_connection_();
-    this->download_error_callback_.call();
-    return;
+    return false;
+  }
+  return true;
+}
+
+ImageFormat OnlineImage::detect_format_(const uint8_t *data, size_t size) const {
+  // Signatures at the start of the file
+  static const uint8_t PNG_SIGNATURE[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  if (size >= sizeof(PNG_SIGNATURE) && memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0) {
+    return ImageFormat::PNG;
+  }
+  if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) {
+    return ImageFormat::JPEG;
+  }
+  if (size >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WEBP", 4) == 0) {
+    return ImageFormat::WEBP;
+  }
+  if (size >= 2 && data[0] == 'B' && data[1] == 'M') {
+    return ImageFormat::BMP;
+  }
+  if (size >= 4 && memcmp(data, "qoif", 4) == 0) {
+    return ImageFormat::QOI;
+  }
+  if (size >= 4 && memcmp(data, "GIF8", 4) == 0) {
+    return ImageFormat::GIF;
   }
-  ESP_LOGI(TAG, "Downloading image (Size: %d)", total_size);
-  this->start_time_ = ::time(nullptr);
+
+  // Fall back to the MIME type sent by the server
+  if (this->content_type_.find("image/png") == 0) {
+    return ImageFormat::PNG;
+  }
+  if (this->content_type_.find("image/jpeg") == 0 || this->content_type_.find("image/jpg") == 0) {
+    return ImageFormat::JPEG;
+  }
+  if (this->content_type_.find("image/webp") == 0) {
+    return ImageFormat::WEBP;
+  }
+  if (this->content_type_.find("image/bmp") == 0) {
+    return ImageFormat::BMP;
+  }
+  if (this->content_type_.find("image/qoi") == 0) {
+    return ImageFormat::QOI;
+  }
+  if (this->content_type_.find("image/gif") == 0) {
+    return ImageFormat::GIF;
+  }
+  return ImageFormat::AUTO;
+}
+
+DownloadStatus OnlineImage::start_decoder_(bool complete) {
+  // Enough to tell all supported signatures apart
+  static const size_t SIGNATURE_SIZE = 12;
+  size_t unread = this->download_buffer_.unread();
+  if (unread < SIGNATURE_SIZE && !complete) {
+    return DOWNLOAD_IN_PROGRESS;
+  }
+  auto format = this->detect_format_(this->download_buffer_.data(), unread);
+  if (format == ImageFormat::AUTO) {
+    ESP_LOGE(TAG, "Could not detect image format (Content-Type: %s)", this->content_type_.c_str());
+    return DOWNLOAD_ERROR;
+  }
+  ESP_LOGD(TAG, "Detected image format: %d", format);
+  return this->create_decoder_(format) ? DOWNLOAD_IN_PROGRESS : DOWNLOAD_ERROR;
 }
 
 void OnlineImage::loop() {
-  if (!this->decoder_) {
+  if (this->autoplay_) {
+    this->play_animation_();
+  }
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  if (this->decode_task_handle_ != nullptr) {
+    auto status = this->task_status_.load();
+    if (status == DOWNLOAD_IDLE || status == DOWNLOAD_IN_PROGRESS) {
+      return;
+    }
+    this->task_status_.store(DOWNLOAD_IDLE);
+    this->finish_download_(status);
+    if (this->release_pending_) {
+      this->release_pending_ = false;
+      this->release();
+    }
+    return;
+  }
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  if (!this->decoder_ && !this->downloader_) {
     // Not decoding at the moment => nothing to do.
     return;
   }
-  if (!this->downloader_ || this->decoder_->is_finished()) {
-    this->data_start_ = buffer_;
-    this->animation_data_start_ = this->buffer_;
-    this->width_ = buffer_width_;
-    this->height_ = buffer_height_;
-    ESP_LOGD(TAG, "Image fully downloaded, read %zu bytes, width/height = %d/%d", this->downloader_->get_bytes_read(),
-             this->width_, this->height_);
-    ESP_LOGD(TAG, "Total time: %lds", ::time(nullptr) - this->start_time_);
-    this->end_connection_();
-    this->download_finished_callback_.call();
+  auto status = this->download_step_();
+  if (status != DOWNLOAD_IN_PROGRESS) {
+    this->finish_download_(status);
+  } else if (this->progressive_) {
+    this->show_progress_();
+  }
+}
+
+void OnlineImage::play_animation_() {
+  if (!this->front_.buffer && this->is_decoding_in_background_()) {
+    // The task is decoding the next image into the buffer; nothing is shown.
     return;
   }
-  if (this->downloader_ == nullptr) {
-    ESP_LOGE(TAG, "Downloader not instantiated; cannot download");
+  if (this->animation_frame_count_ < 2 || !this->data_start_) {
     return;
   }
+  uint32_t now = millis();
+  if (this->current_frame_ != this->played_frame_) {
+    // Set by an action; show it for its full duration.
+    this->played_frame_ = this->current_frame_;
+    this->played_frame_ms_ = now;
+    return;
+  }
+  uint32_t duration = this->get_frame_duration(this->current_frame_);
+  uint32_t elapsed = now - this->played_frame_ms_;
+  if (elapsed < duration) {
+    return;
+  }
+  // Keep the pace when the loop runs late, but do not rush through frames to catch up.
+  this->played_frame_ms_ = elapsed - duration < duration ? this->played_frame_ms_ + duration : now;
+  this->next_frame();
+  if (this->current_frame_ != this->played_frame_) {
+    this->played_frame_ = this->current_frame_;
+    this->frame_changed_callback_.call();
+  }
+}
+
+uint32_t OnlineImage::get_frame_duration(int frame) const {
+  if (!this->front_.buffer && this->is_decoding_in_background_()) {
+    // The task is filling in the durations of the next image.
+    return DEFAULT_FRAME_DURATION_MS;
+  }
+  // While a double buffered update is decoded, the frames shown are those of the front image.
+  const auto &durations = this->front_.buffer ? this->front_.frame_durations : this->frame_durations_;
+  if (frame < 0 || static_cast<size_t>(frame) >= durations.size() || durations[frame] < MIN_FRAME_DURATION_MS) {
+    return DEFAULT_FRAME_DURATION_MS;
+  }
+  return durations[frame];
+}
+
+void OnlineImage::show_progress_() {
+  if (!this->decoder_ || !this->decoder_->is_progressive() || !this->buffer_ || this->front_.buffer ||
+      this->progress_row_ == 0 || this->progress_row_ == this->height_) {
+    return;
+  }
+  this->data_start_ = this->buffer_;
+  this->animation_data_start_ = this->buffer_;
+  this->width_ = this->buffer_width_;
+  this->height_ = this->progress_row_;
+  this->animation_frame_count_ = this->buffer_frame_count_;
+  this->current_frame_ = 0;
+}
+
+DownloadStatus OnlineImage::download_step_() {
+  if (!this->downloader_ || (this->decoder_ && this->decoder_->is_finished())) {
+    return DOWNLOAD_FINISHED;
+  }
   size_t available = this->download_buffer_.free_capacity();
+  if (!available && this->unknown_length_) {
+    size_t size = this->download_buffer_.size();
+    size_t new_size = std::min(size * 2, this->max_download_buffer_size_);
+    if (new_size <= size) {
+      ESP_LOGE(TAG, "Image does not fit in the maximum download buffer size of %zu bytes",
+               this->max_download_buffer_size_);
+      return DOWNLOAD_ERROR;
+    }
+    ESP_LOGD(TAG, "Growing download buffer to %zu bytes", new_size);
+    if (this->download_buffer_.resize(new_size) == 0) {
+      return DOWNLOAD_ERROR;
+    }
+    available = this->download_buffer_.free_capacity();
+  }
   if (available) {
     // Some decoders need to fully download the image before downloading.
     // In case of huge images, don't wait blocking until the whole image has been downloaded,
     // use smaller chunks
     available = std::min(available, this->download_buffer_initial_size_);
     auto len = this->downloader_->read(this->download_buffer_.append(), available);
+    if (len < 0) {
+      ESP_LOGE(TAG, "Connection lost after %zu bytes", this->downloader_->get_bytes_read());
+      this->connection_lost_ = true;
+      return DOWNLOAD_ERROR;
+    }
     if (len > 0) {
+      this->bytes_downloaded_ += len;
       this->download_buffer_.write(len);
-      auto fed = this->decoder_->decode(this->download_buffer_.data(), this->download_buffer_.unread());
-      if (fed < 0) {
-        ESP_LOGE(TAG, "Error when decoding image.");
-        this->end_connection_();
-        this->download_error_callback_.call();
-        return;
+      if (!this->decoder_) {
+        auto status = this->start_decoder_(false);
+        if (!this->decoder_) {
+          return status;
+        }
+      }
+      if (!this->decode_()) {
+        return DOWNLOAD_ERROR;
       }
+    } else if (this->unknown_length_) {
+      // With esp-idf, reads block until data arrives, and only return 0 at the end of the stream.
+      return this->end_of_stream_();
+    }
+  }
+  return DOWNLOAD_IN_PROGRESS;
+}
+
+bool OnlineImage::decode_() {
+  uint32_t start = micros();
+  int fed;
+  // Decoders may stop early, like the BMP decoder after resizing the download buffer. Feed them
+  // the rest right away: no more data may arrive to trigger the next call.
+  do {
+    fed = this->decoder_->decode(this->download_buffer_.data(), this->download_buffer_.unread());
+    if (fed > 0) {
       this->download_buffer_.read(fed);
     }
+  } while (fed > 0 && this->download_buffer_.unread() > 0 && !this->decoder_->is_finished());
+  this->decode_us_ += micros() - start;
+  if (fed < 0) {
+    ESP_LOGE(TAG, "Error when decoding image.");
+    return false;
+  }
+  return true;
+}
+
+void OnlineImage::log_decode_stats_() {
+  uint32_t total_ms = millis() - this->start_ms_;
+  size_t bytes = this->downloader_ ? this->downloader_->get_bytes_read() : 0;
+  // Bytes per microsecond are MB/s.
+  float decode_s = this->decode_us_ / 1e6f;
+  ESP_LOGD(TAG, "Total time: %" PRIu32 "ms, of which decoding: %" PRIu32 "ms", total_ms, this->decode_us_ / 1000);
+  if (this->decode_us_ > 0) {
+    ESP_LOGD(TAG, "Decoded %.2f MB/s, %.0f pixels/s", float(bytes) / this->decode_us_,
+             this->pixels_drawn_ / decode_s);
+  }
+  ESP_LOGD(TAG, "Pixels drawn: %" PRIu32 " (%.2f per image pixel)", this->pixels_drawn_,
+           this->width_ * this->height_ > 0 ? float(this->pixels_drawn_) / (this->width_ * this->height_) : 0.0f);
+  ESP_LOGD(TAG, "Download buffer compaction moved %zu bytes", this->download_buffer_.get_bytes_copied());
+  size_t frames = (this->frame_store_ ? this->frame_store_->size() : 0) +
+                  (this->frame_source_ ? this->frame_source_->get_retained_size() : 0);
+  ESP_LOGD(TAG, "Memory: %zu bytes of image buffer, %zu bytes of frames, %zu bytes of download buffer",
+           this->get_allocated_size_(), frames, this->download_buffer_.size());
+}
+
+DownloadStatus OnlineImage::end_of_stream_() {
+  size_t total_size = this->downloader_->get_bytes_read();
+  if (total_size == 0) {
+    ESP_LOGE(TAG, "Empty response.");
+    return DOWNLOAD_ERROR;
+  }
+  ESP_LOGD(TAG, "End of stream after %zu bytes", total_size);
+  if (!this->decoder_ && this->start_decoder_(true) != DOWNLOAD_IN_PROGRESS) {
+    return DOWNLOAD_ERROR;
+  }
+  this->decoder_->set_download_size(total_size);
+  // Let the decoder see what is left; decoders needing the whole file start only now.
+  if (!this->decode_()) {
+    return DOWNLOAD_ERROR;
+  }
+  if (!this->decoder_->is_finished()) {
+    ESP_LOGE(TAG, "Stream ended before the image was complete.");
+    return DOWNLOAD_ERROR;
+  }
+  return DOWNLOAD_FINISHED;
+}
+
+void OnlineImage::finish_download_(DownloadStatus status) {
+  size_t resumed_bytes = this->resume_offset_;
+  if (status == DOWNLOAD_ERROR) {
+    // Before the validators of the failed download are dropped
+    this->keep_partial_download_(resumed_bytes);
+  } else {
+    this->resume_offset_ = 0;
+  }
+  if (status == DOWNLOAD_FINISHED) {
+    if (this->decoder_ && this->decoder_->get_on_demand_frames() > 1) {
+      // The decoder draws the frames when shown; keep it once the connection is closed.
+      this->buffer_frame_count_ = this->decoder_->get_on_demand_frames();
+      this->frame_source_ = std::move(this->decoder_);
+      this->stored_frame_ = 0;
+    } else if (this->compress_frames_ && this->buffer_frame_count_ > 1) {
+      this->build_frame_store_();
+    }
+    if (this->palette_ && !this->frame_source_) {
+      // No more colors are added until the next download.
+      this->palette_->release_lookup();
+    }
+    if (this->viewport_ && (this->buffer_x_ != this->viewport_x_ || this->buffer_y_ != this->viewport_y_)) {
+      // The viewport moved during the download; the next update must download the image in full.
+      this->clear_validators_();
+    }
+    this->free_front_image_();
+    this->publish_image_();
+    this->fetched_ms_ = millis();
+    ESP_LOGD(TAG, "Image fully downloaded, read %zu bytes, width/height = %d/%d",
+             this->downloader_ ? this->downloader_->get_bytes_read() : 0, this->width_, this->height_);
+    if (resumed_bytes > 0) {
+      ESP_LOGD(TAG, "Resumed the download; %zu bytes were kept from an interrupted one", resumed_bytes);
+    }
+    this->log_decode_stats_();
+  } else if (status == DOWNLOAD_NOT_MODIFIED) {
+    ESP_LOGD(TAG, "Image not modified on server");
+    if (this->front_.buffer) {
+      // Keep the animation going where it was.
+      int frame = this->current_frame_;
+      this->attach_image_(this->front_);
+      this->set_frame(frame);
+    } else if (this->buffer_ && !this->data_start_) {
+      // The image may have been hidden for a background update; the buffer is still valid.
+      this->data_start_ = this->buffer_;
+    }
+    this->fetched_ms_ = millis();
+  } else if (status == DOWNLOAD_ERROR) {
+    if (this->front_.buffer) {
+      // Drop the partially decoded image and go back to the one on screen.
+      this->attach_image_(this->front_);
+    } else if (!this->decoder_ && this->buffer_ && !this->data_start_) {
+      // Nothing was decoded; the image hidden for a background update is still valid.
+      this->data_start_ = this->buffer_;
+    } else {
+      // The buffer may have been partially overwritten; it must be downloaded in full next time.
+      this->clear_validators_();
+    }
+  }
+  this->end_connection_();
+  if (status == DOWNLOAD_FINISHED) {
+    this->download_finished_callback_.call();
+  } else if (status == DOWNLOAD_ERROR) {
+    this->download_error_callback_.call();
   }
 }
 
@@ -267,10 +1110,22 @@ void OnlineImage::draw_pixel_(int x, int y, Color color, int frame) {
     ESP_LOGE(TAG, "Buffer not allocated!");
     return;
   }
-  if (x < 0 || y < 0 || frame < 0 || x >= this->buffer_width_ || y >= this->buffer_height_ || frame >= this->animation_frame_count_) {
+  this->pixels_drawn_++;
+  if (this->viewport_) {
+    x -= this->buffer_x_;
+    y -= this->buffer_y_;
+    if (x < 0 || y < 0 || x >= this->buffer_width_ || y >= this->buffer_height_) {
+      // Outside of the viewport
+      return;
+    }
+  }
+  if (x < 0 || y < 0 || frame < 0 || x >= this->buffer_width_ || y >= this->buffer_height_ || frame >= this->buffer_frame_count_) {
     ESP_LOGE(TAG, "Tried to paint a pixel (%d,%d,%d) outside the image!", x, y, frame);
     return;
   }
+  if (y > this->progress_row_) {
+    this->progress_row_ = y;
+  }
   uint32_t pos = this->get_position_(x, y, frame);
   
   // Additional safety check for calculated position
@@ -279,19 +1134,40 @@ void OnlineImage::draw_pixel_(int x, int y, Color color, int frame) {
     ESP_LOGE(TAG, "Calculated position %u exceeds buffer size %zu", pos, buffer_size);
     return;
   }
+  if (this->palette_) {
+    this->buffer_[pos] = this->palette_->get_index(color);
+    return;
+  }
+  this->store_pixel_(this->buffer_ + this->get_row_offset_(y, frame), x, color);
+}
+
+void OnlineImage::store_pixels_(int x, int y, const Color *colors, int count) {
+  if (!this->buffer_ || this->palette_ || this->viewport_ || x < 0 || y < 0 || count < 0 ||
+      x + count > this->buffer_width_ || y >= this->buffer_height_) {
+    ESP_LOGE(TAG, "Tried to store pixels (%d-%d,%d) outside the image!", x, x + count, y);
+    return;
+  }
+  this->pixels_drawn_ += count;
+  if (y > this->progress_row_) {
+    this->progress_row_ = y;
+  }
+  uint8_t *row = this->buffer_ + this->get_row_offset_(y);
+  for (int i = 0; i < count; i++) {
+    this->store_pixel_(row, x + i, colors[i]);
+  }
+}
+
+inline void OnlineImage::store_pixel_(uint8_t *row, int x, Color color) {
   switch (this->type_) {
     case ImageType::IMAGE_TYPE_BINARY: {
-      const uint32_t width_8 = ((this->width_ + 7u) / 8u) * 8u;
-      pos = x + y * width_8;
-      auto bitno = 0x80 >> (pos % 8u);
-      pos /= 8u;
+      auto bitno = 0x80 >> (x % 8u);
       auto on = is_color_on(color);
       if (this->has_transparency() && color.w < 0x80)
         on = false;
       if (on) {
-        this->buffer_[pos] |= bitno;
+        row[x / 8u] |= bitno;
       } else {
-        this->buffer_[pos] &= ~bitno;
+        row[x / 8u] &= ~bitno;
       }
       break;
     }
@@ -308,51 +1184,158 @@ void OnlineImage::draw_pixel_(int x, int y, Color color, int frame) {
         if (color.w != 0xFF)
           gray = color.w;
       }
-      this->buffer_[pos] = gray;
+      row[x] = gray;
       break;
     }
     case ImageType::IMAGE_TYPE_RGB565: {
       this->map_chroma_key(color);
       uint16_t col565 = display::ColorUtil::color_to_565(color);
-      // Check bounds for multi-byte access
-      size_t bytes_needed = this->transparency_ == image::TRANSPARENCY_ALPHA_CHANNEL ? 3 : 2;
-      if (pos + bytes_needed > buffer_size) {
-        ESP_LOGE(TAG, "RGB565 pixel write would exceed buffer bounds");
-        return;
-      }
-      this->buffer_[pos + 0] = static_cast<uint8_t>((col565 >> 8) & 0xFF);
-      this->buffer_[pos + 1] = static_cast<uint8_t>(col565 & 0xFF);
       if (this->transparency_ == image::TRANSPARENCY_ALPHA_CHANNEL) {
-        this->buffer_[pos + 2] = color.w;
+        uint8_t *pixel = row + x * 3;
+        pixel[0] = static_cast<uint8_t>((col565 >> 8) & 0xFF);
+        pixel[1] = static_cast<uint8_t>(col565 & 0xFF);
+        pixel[2] = color.w;
+      } else {
+        uint8_t *pixel = row + x * 2;
+        pixel[0] = static_cast<uint8_t>((col565 >> 8) & 0xFF);
+        pixel[1] = static_cast<uint8_t>(col565 & 0xFF);
       }
       break;
     }
     case ImageType::IMAGE_TYPE_RGB: {
       this->map_chroma_key(color);
-      // Check bounds for multi-byte access
-      size_t bytes_needed = this->transparency_ == image::TRANSPARENCY_ALPHA_CHANNEL ? 4 : 3;
-      if (pos + bytes_needed > buffer_size) {
-        ESP_LOGE(TAG, "RGB pixel write would exceed buffer bounds");
-        return;
-      }
-      this->buffer_[pos + 0] = color.r;
-      this->buffer_[pos + 1] = color.g;
-      this->buffer_[pos + 2] = color.b;
       if (this->transparency_ == image::TRANSPARENCY_ALPHA_CHANNEL) {
-        this->buffer_[pos + 3] = color.w;
+        uint8_t *pixel = row + x * 4;
+        pixel[0] = color.r;
+        pixel[1] = color.g;
+        pixel[2] = color.b;
+        pixel[3] = color.w;
+      } else {
+        uint8_t *pixel = row + x * 3;
+        pixel[0] = color.r;
+        pixel[1] = color.g;
+        pixel[2] = color.b;
       }
       break;
     }
   }
 }
 
+void OnlineImage::copy_frame_(int source, int target) {
+  if (!this->buffer_ || this->frame_store_ || this->frame_source_ || source < 0 || target < 0 ||
+      source >= this->buffer_frame_count_ || target >= this->buffer_frame_count_) {
+    ESP_LOGE(TAG, "Tried to copy frame %d to %d outside the image!", source, target);
+    return;
+  }
+  memcpy(this->buffer_ + target * this->buffer_frame_size_, this->buffer_ + source * this->buffer_frame_size_,
+         this->buffer_frame_size_);
+}
+
+void OnlineImage::show_frame_() {
+  if (this->current_frame_ != this->stored_frame_) {
+    uint32_t start = micros();
+    if (!this->frame_source_->render_frame(this->current_frame_)) {
+      ESP_LOGW(TAG, "Could not draw frame %d", this->current_frame_);
+    }
+    ESP_LOGV(TAG, "Drew frame %d in %" PRIu32 "us", this->current_frame_, micros() - start);
+    this->stored_frame_ = this->current_frame_;
+  }
+  // Animation points data_start_ at the frame's offset in a raw buffer; the single frame is always at the start.
+  this->data_start_ = this->buffer_;
+}
+
+void OnlineImage::build_frame_store_() {
+  auto store = make_unique<FrameStore>();
+  size_t raw_size = this->get_buffer_size_();
+  if (!store->encode(this->buffer_, this->buffer_frame_size_, this->buffer_frame_count_)) {
+    ESP_LOGW(TAG, "Not enough memory to compress frames; keeping raw frames");
+    return;
+  }
+  if (store->size() + this->buffer_frame_size_ >= raw_size) {
+    ESP_LOGD(TAG, "Compressing frames saves no memory; keeping raw frames");
+    return;
+  }
+  uint8_t *working_frame = this->allocator_.allocate(this->buffer_frame_size_);
+  if (working_frame == nullptr) {
+    ESP_LOGW(TAG, "Not enough memory for the working frame; keeping raw frames");
+    return;
+  }
+  memcpy(working_frame, this->buffer_, this->buffer_frame_size_);
+  this->allocator_.deallocate(this->buffer_, raw_size);
+  this->buffer_ = working_frame;
+  this->frame_store_ = std::move(store);
+  this->stored_frame_ = 0;
+  ESP_LOGD(TAG, "Compressed %d frames: %zu -> %zu bytes", this->buffer_frame_count_, raw_size,
+           this->frame_store_->size() + this->buffer_frame_size_);
+}
+
+void OnlineImage::restore_frame_(FrameStore *store, uint8_t *working_frame, int &stored_frame) {
+  if (this->current_frame_ != stored_frame) {
+    uint32_t start = micros();
+    store->restore(working_frame, stored_frame, this->current_frame_);
+    ESP_LOGV(TAG, "Restored frame %d in %" PRIu32 "us", this->current_frame_, micros() - start);
+    stored_frame = this->current_frame_;
+  }
+  // Animation points data_start_ at the frame's offset in a raw buffer; the working frame is always at the start.
+  this->data_start_ = working_frame;
+}
+
+void OnlineImage::release_frame_store_() {
+  this->allocator_.deallocate(this->buffer_, this->buffer_frame_size_);
+  this->buffer_ = nullptr;
+  this->data_start_ = nullptr;
+  this->animation_data_start_ = nullptr;
+  this->frame_store_.reset();
+}
+
 void OnlineImage::end_connection_() {
   if (this->downloader_) {
     this->downloader_->end();
     this->downloader_ = nullptr;
   }
   this->decoder_.reset();
-  this->download_buffer_.reset();
+  if (this->resume_offset_ == 0) {
+    this->download_buffer_.reset();
+  }
+}
+
+void OnlineImage::keep_partial_download_(size_t kept) {
+  if (!this->downloader_) {
+    // The server could not be reached; nothing changed since the last attempt.
+    return;
+  }
+  this->resume_offset_ = 0;
+  if (!this->connection_lost_ || this->unknown_length_ || (this->etag_.empty() && this->last_modified_.empty())) {
+    return;
+  }
+  // The bytes read only count those of the last request.
+  size_t received = kept + this->downloader_->get_bytes_read();
+  if (received == 0 || received >= this->download_size_ || this->download_buffer_.unread() != received) {
+    // Part of the data has been decoded already, and is gone from the download buffer.
+    return;
+  }
+  ESP_LOGI(TAG, "Keeping %zu of %zu bytes to resume the download", received, this->download_size_);
+  this->resume_offset_ = received;
+  this->resume_url_ = this->validators_url_;
+  this->resume_etag_ = this->etag_;
+  this->resume_last_modified_ = this->last_modified_;
+  this->resume_size_ = this->download_size_;
+}
+
+bool OnlineImage::check_content_range_(const std::string &content_range) const {
+  // Content-Range: bytes <first>-<last>/<total>
+  size_t first;
+  size_t last;
+  size_t total;
+  if (sscanf(content_range.c_str(), "bytes %zu-%zu/%zu", &first, &last, &total) != 3) {
+    ESP_LOGE(TAG, "Invalid Content-Range: %s", content_range.c_str());
+    return false;
+  }
+  if (first != this->resume_offset_ || total != this->resume_size_ || last + 1 != total) {
+    ESP_LOGE(TAG, "Content-Range %s does not continue the download", content_range.c_str());
+    return false;
+  }
+  return true;
 }
 
 bool OnlineImage::validate_url_(const std::string &url) {
@@ -371,5 +1354,9 @@ void OnlineImage::add_on_error_callback(std::function<void()> &&callback) {
   this->download_error_callback_.add(std::move(callback));
 }
 
+void OnlineImage::add_on_frame_changed_callback(std::function<void()> &&callback) {
+  this->frame_changed_callback_.add(std::move(callback));
+}
+
 }  // namespace online_image
 }  // namespace esphome
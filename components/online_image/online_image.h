@@ -7,13 +7,25 @@
 #include "esphome/core/defines.h"
 #include "esphome/core/helpers.h"
 
+#include "frame_store.h"
+#include "image_cache.h"
 #include "image_decoder.h"
+#include "palette.h"
+
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+#include <atomic>
+
+// FreeRTOS for background task
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
 
 namespace esphome {
 namespace online_image {
 
 using t_http_codes = enum {
   HTTP_CODE_OK = 200,
+  HTTP_CODE_PARTIAL_CONTENT = 206,
   HTTP_CODE_NOT_MODIFIED = 304,
   HTTP_CODE_NOT_FOUND = 404,
 };
@@ -22,7 +34,7 @@ using t_http_codes = enum {
  * @brief Format that the image is encoded with.
  */
 enum ImageFormat {
-  /** Automatically detect from MIME type. Not supported yet. */
+  /** Automatically detect from the file signature, or the MIME type. */
   AUTO,
   /** JPEG format. */
   JPEG,
@@ -32,6 +44,26 @@ enum ImageFormat {
   PNG,
   /** BMP format. */
   BMP,
+  /** QOI format. */
+  QOI,
+  /** GIF format. */
+  GIF,
+};
+
+/**
+ * @brief State of a download, as reported by the steps of the download.
+ */
+enum DownloadStatus : uint8_t {
+  /** No download running. */
+  DOWNLOAD_IDLE,
+  /** Download and decoding still going on. */
+  DOWNLOAD_IN_PROGRESS,
+  /** The image has been fully decoded into the buffer. */
+  DOWNLOAD_FINISHED,
+  /** The server reported the image has not changed. */
+  DOWNLOAD_NOT_MODIFIED,
+  /** The download or decoding failed. */
+  DOWNLOAD_ERROR,
 };
 
 /**
@@ -57,16 +89,20 @@ class OnlineImage : public PollingComponent,
 
   void draw(int x, int y, display::Display *display, Color color_on, Color color_off) override;
 
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  void setup() override;
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
   void update() override;
   void loop() override;
   void map_chroma_key(Color &color);
 
-  /** Set the URL to download the image from. */
-  void set_url(const std::string &url) {
-    if (this->validate_url_(url)) {
-      this->url_ = url;
-    }
-  }
+  /**
+   * @brief Set the URL to download the image from.
+   *
+   * If a cache has been set up, the current image is kept in the cache, and a cached image
+   * for the new URL is shown right away.
+   */
+  void set_url(const std::string &url);
 
   /**
    * @brief Set the image that needs to be shown as long as the downloaded image
@@ -76,6 +112,98 @@ class OnlineImage : public PollingComponent,
    */
   void set_placeholder(image::Image *placeholder) { this->placeholder_ = placeholder; }
 
+  /**
+   * @brief Keep the frames of animated images compressed in memory.
+   *
+   * Only the first frame and the differences between consecutive frames are stored;
+   * the visible frame is reconstructed into a single working frame when needed.
+   */
+  void set_compress_frames(bool compress_frames) { this->compress_frames_ = compress_frames; }
+
+  /**
+   * @brief Download and decode the image in a separate task instead of the main loop.
+   *
+   * The main loop only picks up the finished image. Without double buffering, the image is
+   * hidden during updates, as the task decodes into its buffer. Only has an effect if the
+   * component has been built with USE_ONLINE_IMAGE_BACKGROUND_DECODE.
+   */
+  void set_background_decode(bool background_decode) { this->background_decode_ = background_decode; }
+
+  /**
+   * @brief Set the size up to which the download buffer may grow for images sent without a Content-Length.
+   *
+   * Such images (chunked responses) can only be downloaded with the esp-idf framework.
+   */
+  void set_max_download_buffer_size(size_t size) { this->max_download_buffer_size_ = size; }
+
+  /**
+   * @brief Keep the decoded images of previous URLs in memory.
+   *
+   * @param max_size Maximum number of bytes used by the cached images, besides the image shown.
+   * @param max_age_ms Time during which an image is shown without checking the server for a new version.
+   */
+  void set_cache(size_t max_size, uint32_t max_age_ms) {
+    this->cache_ = make_unique<ImageCache>(max_size, max_age_ms);
+  }
+
+  /**
+   * @brief Decode updates into a second buffer, and only show them once complete.
+   *
+   * The previous image stays on screen during the download, at the cost of holding two
+   * images in memory while decoding.
+   */
+  void set_double_buffer(bool double_buffer) { this->double_buffer_ = double_buffer; }
+
+  /**
+   * @brief Show the rows decoded so far while the image is still downloading.
+   *
+   * Only has an effect for decoders drawing row by row (non-interlaced PNG), and not together
+   * with double buffering or background decoding.
+   */
+  void set_progressive(bool progressive) { this->progressive_ = progressive; }
+
+  /**
+   * @brief Keep animated GIF images compressed, and decode each frame when it is shown.
+   *
+   * The image buffer then only holds a single frame.
+   */
+  void set_on_demand_frames(bool on_demand_frames) { this->on_demand_frames_ = on_demand_frames; }
+
+  /**
+   * @brief Store one byte per pixel, indexing a palette of up to 256 colors.
+   *
+   * Colors beyond the first 256 are mapped to the nearest palette entry. Only the color image
+   * types benefit from this; get_pixel() does not support indexed images.
+   */
+  void set_indexed(bool indexed) { this->indexed_ = indexed; }
+
+  /**
+   * @brief Only keep a region of the downloaded image, at its original size.
+   *
+   * The image buffer has the configured width and height; the region starts at (x, y) in the
+   * downloaded image. Moving the viewport downloads the image again on the next update.
+   */
+  void set_viewport(int x, int y);
+
+  /**
+   * @brief Advance the frames of animated images by themselves, each shown for the time set in the file.
+   *
+   * The frame changed callbacks are called whenever another frame becomes visible, so that the
+   * display only needs to be redrawn then.
+   */
+  void set_autoplay(bool autoplay) { this->autoplay_ = autoplay; }
+
+  /**
+   * @brief Time during which a frame of the image shown is displayed when playing the animation.
+   *
+   * Frames without a duration, or one too short to be meant literally, are shown for
+   * DEFAULT_FRAME_DURATION_MS, as browsers do.
+   */
+  uint32_t get_frame_duration(int frame) const;
+
+  /** Set the filter used to scale the decoded image to the configured size. */
+  void set_resize_filter(ResizeFilter resize_filter) { this->resize_filter_ = resize_filter; }
+
   /**
    * Release the buffer storing the image. The image will need to be downloaded again
    * to be able to be displayed.
@@ -89,20 +217,48 @@ class OnlineImage : public PollingComponent,
    */
   size_t resize_download_buffer(size_t size) { return this->download_buffer_.resize(size); }
 
+  /**
+   * @brief Take the memory of the download buffer, for decoders keeping the complete file after
+   * decoding. Downloads continue in a new buffer of the initial size.
+   *
+   * @param capacity Set to the size of the returned allocation, for deallocation.
+   * @return The downloaded data, or nullptr if there is not enough memory for a new buffer.
+   */
+  uint8_t *take_download_buffer(size_t *capacity) {
+    return this->download_buffer_.release(this->download_buffer_initial_size_, capacity);
+  }
+
+  /** Total number of bytes received from the server, over all downloads. */
+  size_t get_bytes_downloaded() const { return this->bytes_downloaded_; }
+
   void add_on_finished_callback(std::function<void()> &&callback);
   void add_on_error_callback(std::function<void()> &&callback);
+  void add_on_frame_changed_callback(std::function<void()> &&callback);
 
  protected:
   bool validate_url_(const std::string &url);
 
   RAMAllocator<uint8_t> allocator_{};
 
-  uint32_t get_buffer_size_() const { return get_buffer_size_(this->buffer_width_, this->buffer_height_, this->animation_frame_count_); }
-  int get_buffer_size_(int width, int height, int frames) const { return frames * ((this->get_bpp() * width + 7u) / 8u * height); }
+  uint32_t get_buffer_size_() const { return get_buffer_size_(this->buffer_width_, this->buffer_height_, this->buffer_frame_count_); }
+  int get_buffer_size_(int width, int height, int frames) const {
+    return frames * get_frame_size_(width, height, this->get_buffer_bpp_());
+  }
+  static int get_frame_size_(int width, int height, int bpp) { return (bpp * width + 7u) / 8u * height; }
+  /** Bits per pixel in the buffer; indexed images use one byte per pixel whatever the image type. */
+  int get_buffer_bpp_() const { return this->palette_ ? 8 : this->get_bpp(); }
+  /** Size of the allocated buffer, which only holds one frame if frames are compressed or drawn on demand. */
+  size_t get_allocated_size_() const {
+    return this->frame_store_ || this->frame_source_ ? this->buffer_frame_size_ : this->get_buffer_size_();
+  }
 
   int get_position_(int x, int y, int frame = 0) const {
     int frame_offset = this->buffer_frame_size_ * frame;
-    return ((x + y * this->buffer_width_) * this->get_bpp() / 8) + frame_offset;
+    return ((x + y * this->buffer_width_) * this->get_buffer_bpp_() / 8) + frame_offset;
+  }
+  /** Offset of the first byte of row y of a frame in the image buffer. */
+  int get_row_offset_(int y, int frame = 0) const {
+    return this->buffer_frame_size_ * frame + (this->get_buffer_bpp_() * this->buffer_width_ + 7u) / 8u * y;
   }
 
   ESPHOME_ALWAYS_INLINE bool is_auto_resize_() const { return this->fixed_width_ == 0 || this->fixed_height_ == 0; }
@@ -123,6 +279,17 @@ class OnlineImage : public PollingComponent,
    */
   size_t resize_(int width, int height, int frames = 1);
 
+  /**
+   * @brief Allocate the image buffer, degrading the image until it fits in memory.
+   *
+   * If the full image does not fit, the buffer is allocated with fewer frames, then at a smaller
+   * size, and as a last resort with indexed colors (for color types), until the allocation succeeds.
+   * The resampler scales the decoded image to whatever size has been allocated.
+   *
+   * @return false if even the smallest image could not be allocated.
+   */
+  bool allocate_buffer_(int width, int height, int frames);
+
   /**
    * @brief Draw a pixel into the buffer.
    *
@@ -136,16 +303,219 @@ class OnlineImage : public PollingComponent,
    * @param frame the frame to draw the image buffer to if animated
    */
   void draw_pixel_(int x, int y, Color color, int frame = 0);
+  /**
+   * @brief Write consecutive pixels of a row of the first frame, for decoders delivering pixels at the
+   * size of the buffer. Skips the viewport and palette handling of draw_pixel_(), so only for images
+   * stored without those.
+   *
+   * @param x Horizontal position of the first pixel.
+   * @param y Vertical pixel position.
+   * @param colors The colors to store.
+   * @param count The number of colors.
+   */
+  void store_pixels_(int x, int y, const Color *colors, int count);
+  /** Convert a color to the storage format and write it at column x of a row of the image buffer. */
+  void store_pixel_(uint8_t *row, int x, Color color);
+  /**
+   * @brief Feed the unread data of the download buffer to the decoder.
+   *
+   * @return false if the decoder failed.
+   */
+  bool decode_();
+  /** Log throughput and memory figures of the download just finished. */
+  void log_decode_stats_();
+
+  /**
+   * @brief Copy the visible frame to the display in one call, clipped to the visible area.
+   *
+   * Displays with a native buffer of the same format copy whole rows instead of drawing
+   * pixel by pixel.
+   *
+   * @return false if the image type or transparency needs the generic per-pixel path.
+   */
+  bool blit_(int x, int y, display::Display *display);
+
+  /**
+   * @brief Clip the image drawn at (x, y) to the visible area of the display.
+   *
+   * @return false if nothing of the image is visible; otherwise [x1, x2) x [y1, y2) is.
+   */
+  bool clip_(int x, int y, display::Display *display, int &x1, int &y1, int &x2, int &y2) const;
+
+  /** Draw the visible frame of an indexed image through its palette, a row at a time. */
+  void draw_indexed_(int x, int y, display::Display *display, const Palette &palette);
+
+  /** Copy a frame of the buffer into another frame. */
+  void copy_frame_(int source, int target);
+
+  /** Have the frame source draw the current animation frame, if frames are drawn on demand. */
+  void show_frame_();
 
   void end_connection_();
 
+  /**
+   * @brief Keep the bytes received by a failed download in the download buffer, to resume it.
+   *
+   * Only downloads of a known size, with a validator, and not consumed by the decoder yet
+   * (formats needing the whole file) can be resumed.
+   *
+   * @param kept Bytes kept from an earlier attempt when the download started.
+   */
+  void keep_partial_download_(size_t kept);
+
+  /** Parse the Content-Range of a partial response, and check it continues the interrupted download. */
+  bool check_content_range_(const std::string &content_range) const;
+
+  /** Forget the ETag and Last-Modified of the image in the buffer. */
+  void clear_validators_();
+
+  /** Deallocate the image buffer, without touching a download in progress. */
+  void free_buffer_();
+
+  /** Whether a download is running, in the main loop or in the background. */
+  bool is_downloading_() const;
+
+  /**
+   * @brief Whether the background task is running, and owns the buffer with its palette and frame
+   * durations. Only the front image, if any, may be used by the main loop then.
+   */
+  bool is_decoding_in_background_() const;
+
+  /** Move the image in the buffer, if complete, into the cache. */
+  void cache_image_();
+
+  /** Show the cached image for the given URL, if there is one. */
+  void load_cached_image_(const std::string &url);
+
+  /** Move the image out of the buffer, leaving it empty for the next decode. Nothing visible changes. */
+  void detach_image_(CachedImage &image);
+
+  /** Move an image back into the buffer, and show it. */
+  void attach_image_(CachedImage &image);
+
+  /** Show the image in the buffer. */
+  void publish_image_();
+
+  /** With double buffering, keep the image on screen as front image, so that the next one is decoded aside. */
+  void hold_front_image_();
+
+  /** Free the front image; nothing is shown until the next image is published. */
+  void free_front_image_();
+
+  /** In progressive mode, show the complete rows of the image being decoded. */
+  void show_progress_();
+
+  /**
+   * @brief Connect to the server and set up the decoder.
+   *
+   * @param url The URL to download the image from.
+   * @return DOWNLOAD_IN_PROGRESS if the image needs to be downloaded, otherwise the final status.
+   */
+  DownloadStatus start_download_(const std::string &url);
+
+  /** Instantiate and prepare the decoder for the given format. */
+  bool create_decoder_(ImageFormat format);
+
+  /**
+   * @brief Tell the image format from the first bytes of the file, or else from the Content-Type.
+   *
+   * @return The detected format, or AUTO if it could not be detected.
+   */
+  ImageFormat detect_format_(const uint8_t *data, size_t size) const;
+
+  /**
+   * @brief Create the decoder for an image of format AUTO, once enough data has been downloaded.
+   *
+   * @param complete Whether the download is complete, so no more data can be waited for.
+   * @return DOWNLOAD_IN_PROGRESS if the decoder was created or more data is needed, DOWNLOAD_ERROR otherwise.
+   */
+  DownloadStatus start_decoder_(bool complete);
+
+  /**
+   * @brief Read the next chunk of the image and feed it to the decoder.
+   *
+   * @return DOWNLOAD_IN_PROGRESS as long as the image is not complete, otherwise the final status.
+   */
+  DownloadStatus download_step_();
+
+  /**
+   * @brief Handle the end of a download of unknown length: the total size is now known,
+   * so the decoder can finish.
+   */
+  DownloadStatus end_of_stream_();
+
+  /**
+   * @brief Publish the image (if finished), close the connection and notify listeners.
+   * Must run on the main loop.
+   */
+  void finish_download_(DownloadStatus status);
+
+#ifdef USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  // Background decode task (static so it can be used as task function)
+  static void decode_task(void *arg);
+
+  TaskHandle_t decode_task_handle_ = nullptr;
+  /** Set by the main loop when a download is requested, and by the task when it is done. */
+  std::atomic<DownloadStatus> task_status_{DOWNLOAD_IDLE};
+  /** Copy of the URL for the task, so that set_url() cannot race with the download. */
+  std::string task_url_;
+  bool release_pending_{false};
+#endif  // USE_ONLINE_IMAGE_BACKGROUND_DECODE
+  bool background_decode_{false};
+
+  /**
+   * @brief Replace the fully decoded frames in the buffer by a compressed frame store.
+   *
+   * On success the buffer is shrunk to a single working frame. If the frames cannot be
+   * compressed (not enough memory, or no gain), the raw buffer is kept.
+   */
+  void build_frame_store_();
+
+  /**
+   * @brief Reconstruct the current animation frame into a working frame.
+   *
+   * @param store The compressed frames.
+   * @param working_frame The working frame belonging to the store.
+   * @param stored_frame The frame currently in the working frame; updated.
+   */
+  void restore_frame_(FrameStore *store, uint8_t *working_frame, int &stored_frame);
+
+  /** Drop the compressed frames and the working frame. */
+  void release_frame_store_();
+
   CallbackManager<void()> download_finished_callback_{};
   CallbackManager<void()> download_error_callback_{};
+  CallbackManager<void()> frame_changed_callback_{};
 
   std::shared_ptr<http_request::HttpContainer> downloader_{nullptr};
   std::unique_ptr<ImageDecoder> decoder_{nullptr};
 
   uint8_t *buffer_;
+  /** Compressed frames; when set, buffer_ only holds the working frame. */
+  std::unique_ptr<FrameStore> frame_store_{nullptr};
+  /** Decoder kept to draw frames on demand; when set, buffer_ only holds the frame shown. */
+  std::unique_ptr<ImageDecoder> frame_source_{nullptr};
+  bool on_demand_frames_{false};
+  bool indexed_{false};
+  /** Colors of the image in the buffer, if indexed (configured, or to save memory). */
+  std::unique_ptr<Palette> palette_{nullptr};
+  /** A row of an indexed image expanded to RGB, for drawing. */
+  std::vector<uint8_t> indexed_row_;
+  /** Show the next frame once the current one has been displayed for its duration. */
+  void play_animation_();
+
+  /** Display time of each frame of the buffer, in milliseconds; 0 if unknown. */
+  std::vector<uint32_t> frame_durations_;
+  bool autoplay_{false};
+  /** Frame the animation scheduler last showed, to notice frames set from elsewhere. */
+  int played_frame_{0};
+  /** millis() when the scheduler showed played_frame_. */
+  uint32_t played_frame_ms_{0};
+
+  /** Frame currently reconstructed into the working frame, or drawn by the frame source. */
+  int stored_frame_{0};
+  bool compress_frames_{false};
+  ResizeFilter resize_filter_{RESIZE_FILTER_NEAREST};
   DownloadBuffer download_buffer_;
   /**
    * This is the *initial* size of the download buffer, not the current size.
@@ -153,12 +523,48 @@ class OnlineImage : public PollingComponent,
    * will *not* change even if the download buffer has been resized.
    */
   size_t download_buffer_initial_size_;
+  /** Limit for growing the download buffer when the size of the image is not known in advance. */
+  size_t max_download_buffer_size_{0};
+  /** The current download was sent without a Content-Length. */
+  bool unknown_length_{false};
+  /** Size of the current download, or DOWNLOAD_SIZE_UNKNOWN. */
+  size_t download_size_{0};
+  /** The connection failed while reading, rather than the image failing to decode. */
+  bool connection_lost_{false};
+  /**
+   * Bytes at the start of the download buffer, kept from an interrupted download. They are
+   * requested no more, with a Range request validated by If-Range.
+   */
+  size_t resume_offset_{0};
+  std::string resume_url_{""};
+  std::string resume_etag_{""};
+  std::string resume_last_modified_{""};
+  size_t resume_size_{0};
+  size_t bytes_downloaded_{0};
+  /** Content-Type of the current download; used to pick the decoder if the format is AUTO. */
+  std::string content_type_{""};
 
   const ImageFormat format_;
   image::Image *placeholder_{nullptr};
 
   std::string url_{""};
 
+  /** ETag of the image in the buffer, sent as If-None-Match on the next update. */
+  std::string etag_{""};
+  /** Last-Modified of the image in the buffer, sent as If-Modified-Since on the next update. */
+  std::string last_modified_{""};
+  /** URL the validators were received for; they are only sent again for the same URL. */
+  std::string validators_url_{""};
+  /** millis() when the image in the buffer was last downloaded or confirmed unchanged. */
+  uint32_t fetched_ms_{0};
+  std::unique_ptr<ImageCache> cache_{nullptr};
+  bool double_buffer_{false};
+  /** Image kept on screen while the next one is decoded into the buffer. */
+  CachedImage front_;
+  bool progressive_{false};
+  /** Last buffer row written to; the rows above it are complete for progressive decoders. */
+  int progress_row_{0};
+
   /** width requested on configuration, or 0 if non specified. */
   const int fixed_width_;
   /** height requested on configuration, or 0 if non specified. */
@@ -183,11 +589,37 @@ class OnlineImage : public PollingComponent,
   int buffer_height_;
   /** The calculated size of a single frame for the given width and height in the buffer */
   int buffer_frame_size_;
-
-  time_t start_time_;
+  /**
+   * Number of frames in the buffer. Like the dimensions, this is only handed over to the
+   * animation once the image has been decoded.
+   */
+  int buffer_frame_count_{0};
+  bool viewport_{false};
+  int viewport_x_{0};
+  int viewport_y_{0};
+  /** Position of the viewport in the downloaded image, when the buffer was decoded. */
+  int buffer_x_{0};
+  int buffer_y_{0};
+  /** Only every n-th decoded frame is kept, if memory is short. */
+  int buffer_frame_step_{1};
+  /** The buffer has been allocated with less colors, frames or pixels than requested. */
+  bool buffer_degraded_{false};
+
+  /** millis() when the current download started. */
+  uint32_t start_ms_{0};
+  /** Time spent in the decoder during the current download. */
+  uint32_t decode_us_{0};
+  /** Calls to draw_pixel_() during the current download. */
+  uint32_t pixels_drawn_{0};
 
   friend bool ImageDecoder::set_size(int width, int height, int frames);
   friend void ImageDecoder::draw(int x, int y, int w, int h, const Color &color, int frame);
+  friend void ImageDecoder::feed_wdt();
+  friend void ImageDecoder::copy_frame(int source, int target);
+  friend void ImageDecoder::set_frame_duration(int frame, uint32_t duration_ms);
+  friend bool ImageDecoder::can_store_pixels() const;
+  friend void ImageDecoder::store_pixels(int x, int y, const Color *colors, int count);
+  friend class Resampler;
 };
 
 template<typename... Ts> class OnlineImageSetUrlAction : public Action<Ts...> {
@@ -203,6 +635,20 @@ template<typename... Ts> class OnlineImageSetUrlAction : public Action<Ts...> {
   OnlineImage *parent_;
 };
 
+template<typename... Ts> class OnlineImageSetViewportAction : public Action<Ts...> {
+ public:
+  OnlineImageSetViewportAction(OnlineImage *parent) : parent_(parent) {}
+  TEMPLATABLE_VALUE(int, x)
+  TEMPLATABLE_VALUE(int, y)
+  void play(const Ts &...x) override {
+    this->parent_->set_viewport(this->x_.value(x...), this->y_.value(x...));
+    this->parent_->update();
+  }
+
+ protected:
+  OnlineImage *parent_;
+};
+
 template<typename... Ts> class OnlineImageReleaseAction : public Action<Ts...> {
  public:
   OnlineImageReleaseAction(OnlineImage *parent) : parent_(parent) {}
@@ -219,6 +665,13 @@ class DownloadFinishedTrigger : public Trigger<> {
   }
 };
 
+class FrameChangedTrigger : public Trigger<> {
+ public:
+  explicit FrameChangedTrigger(OnlineImage *parent) {
+    parent->add_on_frame_changed_callback([this]() { this->trigger(); });
+  }
+};
+
 class DownloadErrorTrigger : public Trigger<> {
  public:
   explicit DownloadErrorTrigger(OnlineImage *parent) {
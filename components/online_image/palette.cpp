@@ -0,0 +1,92 @@
+#include "palette.h"
+
+#include <cstring>
+
+namespace esphome {
+namespace online_image {
+
+void Palette::reset(bool transparent) {
+  if (!this->lut_) {
+    this->lut_ = this->allocator_.allocate(LOOKUP_SIZE);
+  }
+  if (this->lut_) {
+    this->lut_valid_ = this->lut_ + LUT_SIZE;
+    this->lut_approximate_ = this->lut_valid_ + LUT_BITS_SIZE;
+    memset(this->lut_valid_, 0, 2 * LUT_BITS_SIZE);
+  }
+  this->transparent_ = transparent;
+  this->size_ = 0;
+  if (transparent) {
+    this->colors_[TRANSPARENT_INDEX] = Color(0, 0, 0, 0);
+    this->size_ = 1;
+  }
+}
+
+uint8_t Palette::get_index(Color color) {
+  if (this->transparent_ && color.w < 0x80) {
+    return TRANSPARENT_INDEX;
+  }
+  color.w = 0xFF;
+  uint16_t key = key_(color);
+  bool valid = this->lut_ && get_bit_(this->lut_valid_, key);
+  if (valid) {
+    uint8_t index = this->lut_[key];
+    // A nearest color is only stored once the palette is full; it is the best there is.
+    if (this->colors_[index] == color || get_bit_(this->lut_approximate_, key)) {
+      return index;
+    }
+  }
+
+  for (int i = 0; i < this->size_; i++) {
+    if (this->colors_[i] == color) {
+      return i;
+    }
+  }
+  if (this->size_ < MAX_COLORS) {
+    uint8_t index = this->size_++;
+    this->colors_[index] = color;
+    if (this->lut_) {
+      this->lut_[key] = index;
+      set_bit_(this->lut_valid_, key);
+    }
+    return index;
+  }
+  uint8_t index = this->find_nearest_(color);
+  // Keep an exact match stored for another color of the same 12-bit group.
+  if (this->lut_ && !valid) {
+    this->lut_[key] = index;
+    set_bit_(this->lut_valid_, key);
+    set_bit_(this->lut_approximate_, key);
+  }
+  return index;
+}
+
+void Palette::release_lookup() {
+  if (this->lut_) {
+    this->allocator_.deallocate(this->lut_, LOOKUP_SIZE);
+  }
+  this->lut_ = nullptr;
+  this->lut_valid_ = nullptr;
+  this->lut_approximate_ = nullptr;
+}
+
+uint8_t Palette::find_nearest_(Color color) const {
+  int best = 0;
+  uint32_t best_distance = UINT32_MAX;
+  for (int i = this->transparent_ ? 1 : 0; i < this->size_; i++) {
+    const Color &entry = this->colors_[i];
+    int dr = entry.r - color.r;
+    int dg = entry.g - color.g;
+    int db = entry.b - color.b;
+    // Weighted for the sensitivity of the eye to each channel
+    uint32_t distance = 2 * dr * dr + 4 * dg * dg + 3 * db * db;
+    if (distance < best_distance) {
+      best_distance = distance;
+      best = i;
+    }
+  }
+  return best;
+}
+
+}  // namespace online_image
+}  // namespace esphome
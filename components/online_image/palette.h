@@ -0,0 +1,78 @@
+#pragma once
+
+#include "esphome/core/color.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace online_image {
+
+/**
+ * @brief Colors of an image stored with one byte per pixel.
+ *
+ * Colors are added in the order they are first drawn, so images with up to 256 colors
+ * (GIF, palette PNG, pixel art) keep their exact colors. Once the palette is full, further
+ * colors are mapped to the nearest entry.
+ *
+ * A lookup table indexed by the top 4 bits of each channel remembers an entry for every
+ * 12-bit color, so that most pixels are mapped without searching the palette. It is only
+ * needed while colors are added, and is allocated by reset() and freed by release_lookup().
+ * Without it, colors are found by searching the palette.
+ */
+class Palette {
+ public:
+  static const int MAX_COLORS = 256;
+  /** Entry used for transparent pixels, if the image has transparency. */
+  static const uint8_t TRANSPARENT_INDEX = 0;
+
+  Palette() = default;
+  Palette(const Palette &) = delete;
+  Palette &operator=(const Palette &) = delete;
+  ~Palette() { this->release_lookup(); }
+
+  /**
+   * @brief Forget all colors, before a new image is decoded.
+   *
+   * @param transparent Reserve entry TRANSPARENT_INDEX for transparent pixels.
+   */
+  void reset(bool transparent);
+
+  /** @return The entry for the given color, adding it to the palette if there is room. */
+  uint8_t get_index(Color color);
+
+  /** Free the lookup table, once no more colors are added; the colors are kept. */
+  void release_lookup();
+
+  const Color &get_color(uint8_t index) const { return this->colors_[index]; }
+
+  int size() const { return this->size_; }
+
+  /** Bytes used by the palette, including its lookup table. */
+  size_t memory() const { return sizeof(Palette) + (this->lut_ ? LOOKUP_SIZE : 0); }
+
+ protected:
+  static const size_t LUT_SIZE = 4096;
+  static const size_t LUT_BITS_SIZE = 4096 / 8;
+  static const size_t LOOKUP_SIZE = LUT_SIZE + 2 * LUT_BITS_SIZE;
+
+  static uint16_t key_(Color color) { return ((color.r & 0xF0) << 4) | (color.g & 0xF0) | (color.b >> 4); }
+  uint8_t find_nearest_(Color color) const;
+  static bool get_bit_(const uint8_t *bits, uint16_t key) { return bits[key / 8] & (1 << (key % 8)); }
+  static void set_bit_(uint8_t *bits, uint16_t key) { bits[key / 8] |= 1 << (key % 8); }
+
+  Color colors_[MAX_COLORS];
+  int size_{0};
+  bool transparent_{false};
+  RAMAllocator<uint8_t> allocator_{};
+  /**
+   * Entry for each 12-bit color, followed by the bits lut_valid_ and lut_approximate_, in a single
+   * allocation; nullptr without a lookup table.
+   */
+  uint8_t *lut_{nullptr};
+  /** The entry of lut_ is valid. */
+  uint8_t *lut_valid_{nullptr};
+  /** The entry is the nearest color for a full palette, rather than an exact match. */
+  uint8_t *lut_approximate_{nullptr};
+};
+
+}  // namespace online_image
+}  // namespace esphome
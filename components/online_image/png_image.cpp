@@ -20,7 +20,10 @@ namespace online_image {
  */
 static void init_callback(pngle_t *pngle, uint32_t w, uint32_t h) {
   PngDecoder *decoder = (PngDecoder *) pngle_get_user_data(pngle);
-  decoder->set_size(w, h);
+  decoder->interlaced_ = pngle_get_ihdr(pngle)->interlace != 0;
+  if (!decoder->set_size(w, h)) {
+    decoder->out_of_memory_ = true;
+  }
 }
 
 /**
@@ -62,6 +65,9 @@ int HOT PngDecoder::decode(uint8_t *buffer, size_t size) {
     return 0;
   }
   auto fed = pngle_feed(this->pngle_, buffer, size);
+  if (this->out_of_memory_) {
+    return DECODE_ERROR_OUT_OF_MEMORY;
+  }
   if (fed < 0) {
     ESP_LOGE(TAG, "Error decoding image: %s", pngle_error(this->pngle_));
   } else {
@@ -23,8 +23,16 @@ class PngDecoder : public ImageDecoder {
 
   int prepare(size_t download_size) override;
   int HOT decode(uint8_t *buffer, size_t size) override;
+  bool is_progressive() const override { return !this->interlaced_; }
+
+  /** Set when the image buffer could not be allocated for the image's size. */
+  bool out_of_memory_{false};
+  /** Interlaced images are drawn in several passes over the whole image. */
+  bool interlaced_{false};
 
  protected:
+  bool draws_in_raster_order_() const override { return !this->interlaced_; }
+
   pngle_t *pngle_;
 };
 
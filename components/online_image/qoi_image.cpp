@@ -0,0 +1,140 @@
+#include "qoi_image.h"
+
+#ifdef USE_ONLINE_IMAGE_QOI_SUPPORT
+
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+
+#include <cinttypes>
+
+namespace esphome {
+namespace online_image {
+
+static const char *const TAG = "online_image.qoi";
+
+static const size_t HEADER_SIZE = 14;
+
+static const uint8_t QOI_OP_INDEX = 0x00;
+static const uint8_t QOI_OP_DIFF = 0x40;
+static const uint8_t QOI_OP_LUMA = 0x80;
+static const uint8_t QOI_OP_RUN = 0xC0;
+static const uint8_t QOI_OP_RGB = 0xFE;
+static const uint8_t QOI_OP_RGBA = 0xFF;
+static const uint8_t QOI_MASK_2 = 0xC0;
+
+static inline uint8_t color_hash(const Color &c) { return (c.r * 3 + c.g * 5 + c.b * 7 + c.w * 11) % 64; }
+
+int HOT QoiDecoder::decode(uint8_t *buffer, size_t size) {
+  size_t index = 0;
+  if (!this->header_read_) {
+    /**
+     * QOI header:
+     * 0-3: Signature (qoif)
+     * 4-7: Width
+     * 8-11: Height
+     * 12: Channels
+     * 13: Colorspace
+     *
+     * Integer values are stored in big-endian format.
+     */
+    if (size < HEADER_SIZE) {
+      return 0;
+    }
+    if (memcmp(buffer, "qoif", 4) != 0) {
+      ESP_LOGE(TAG, "Not a QOI file");
+      return DECODE_ERROR_INVALID_TYPE;
+    }
+    this->width_ = encode_uint32(buffer[4], buffer[5], buffer[6], buffer[7]);
+    this->height_ = encode_uint32(buffer[8], buffer[9], buffer[10], buffer[11]);
+    if (this->width_ == 0 || this->height_ == 0 || this->width_ > 0xFFFF || this->height_ > 0xFFFF) {
+      ESP_LOGE(TAG, "Invalid image size: %" PRIu32 "x%" PRIu32, this->width_, this->height_);
+      return DECODE_ERROR_INVALID_TYPE;
+    }
+    ESP_LOGD(TAG, "QOI %" PRIu32 "x%" PRIu32 ", %u channels", this->width_, this->height_, buffer[12]);
+    if (!this->set_size(this->width_, this->height_)) {
+      return DECODE_ERROR_OUT_OF_MEMORY;
+    }
+    this->header_read_ = true;
+    index = HEADER_SIZE;
+  }
+
+  const uint32_t total = this->width_ * this->height_;
+  while (this->pixels_ < total) {
+    if (index == size) {
+      break;
+    }
+    uint8_t op = buffer[index];
+    size_t chunk_size = 1;
+    if (op == QOI_OP_RGBA) {
+      chunk_size = 5;
+    } else if (op == QOI_OP_RGB) {
+      chunk_size = 4;
+    } else if ((op & QOI_MASK_2) == QOI_OP_LUMA) {
+      chunk_size = 2;
+    }
+    // Only decode complete chunks; the rest is kept for the next call.
+    if (size - index < chunk_size) {
+      break;
+    }
+    index++;
+    if (op == QOI_OP_RGB) {
+      this->pixel_.r = buffer[index];
+      this->pixel_.g = buffer[index + 1];
+      this->pixel_.b = buffer[index + 2];
+      index += 3;
+      this->emit_(1);
+    } else if (op == QOI_OP_RGBA) {
+      this->pixel_ = Color(buffer[index], buffer[index + 1], buffer[index + 2], buffer[index + 3]);
+      index += 4;
+      this->emit_(1);
+    } else {
+      switch (op & QOI_MASK_2) {
+        case QOI_OP_INDEX:
+          this->pixel_ = this->index_[op];
+          this->emit_(1);
+          break;
+        case QOI_OP_DIFF:
+          this->pixel_.r += ((op >> 4) & 0x03) - 2;
+          this->pixel_.g += ((op >> 2) & 0x03) - 2;
+          this->pixel_.b += (op & 0x03) - 2;
+          this->emit_(1);
+          break;
+        case QOI_OP_LUMA: {
+          int dg = (op & 0x3F) - 32;
+          uint8_t diffs = buffer[index++];
+          this->pixel_.r += dg - 8 + (diffs >> 4);
+          this->pixel_.g += dg;
+          this->pixel_.b += dg - 8 + (diffs & 0x0F);
+          this->emit_(1);
+          break;
+        }
+        case QOI_OP_RUN:
+          this->emit_((op & 0x3F) + 1);
+          break;
+      }
+    }
+  }
+  if (this->pixels_ >= total) {
+    // Skip the end marker
+    index = size;
+  }
+  this->decoded_bytes_ += index;
+  return index;
+}
+
+void HOT QoiDecoder::emit_(int count) {
+  this->index_[color_hash(this->pixel_)] = this->pixel_;
+  for (int i = 0; i < count && this->pixels_ < this->width_ * this->height_; i++) {
+    this->draw(this->x_, this->y_, 1, 1, this->pixel_);
+    this->pixels_++;
+    if (++this->x_ == this->width_) {
+      this->x_ = 0;
+      this->y_++;
+    }
+  }
+}
+
+}  // namespace online_image
+}  // namespace esphome
+
+#endif  // USE_ONLINE_IMAGE_QOI_SUPPORT
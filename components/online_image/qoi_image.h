@@ -0,0 +1,48 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#ifdef USE_ONLINE_IMAGE_QOI_SUPPORT
+
+#include "image_decoder.h"
+
+namespace esphome {
+namespace online_image {
+
+/**
+ * @brief Image decoder specialization for QOI images.
+ *
+ * QOI ("Quite OK Image") is a lossless format that decodes in a single streaming pass
+ * with a table of 64 recently seen colors; no library is needed.
+ */
+class QoiDecoder : public ImageDecoder {
+ public:
+  /**
+   * @brief Construct a new QOI Decoder object.
+   *
+   * @param display The image to decode the stream into.
+   */
+  QoiDecoder(OnlineImage *image) : ImageDecoder(image) {}
+
+  int HOT decode(uint8_t *buffer, size_t size) override;
+  bool is_progressive() const override { return true; }
+
+ protected:
+  /** Paint the current pixel `count` times, and add it to the color table. */
+  void emit_(int count);
+
+  bool header_read_{false};
+  uint32_t width_{0};
+  uint32_t height_{0};
+  /** Number of pixels painted so far. */
+  uint32_t pixels_{0};
+  uint32_t x_{0};
+  uint32_t y_{0};
+  Color pixel_{0, 0, 0, 255};
+  /** Recently seen colors, by hash; all zero (transparent black) initially. */
+  Color index_[64];
+};
+
+}  // namespace online_image
+}  // namespace esphome
+
+#endif  // USE_ONLINE_IMAGE_QOI_SUPPORT
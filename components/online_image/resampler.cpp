@@ -0,0 +1,219 @@
+#include "resampler.h"
+#include "online_image.h"
+
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace online_image {
+
+static const char *const TAG = "online_image.resampler";
+
+/**
+ * Map a source coordinate onto the image buffer, with a 32.32 fixed-point scale. Rounding down takes
+ * the scale rounded up, rounding up the scale rounded down; both are then exact for images of up to
+ * 65535 pixels, where a 16.16 scale puts pixels into the wrong destination pixel once the source is
+ * wider than 256 pixels.
+ */
+static inline int scale_floor(int value, uint64_t scale) { return (static_cast<uint64_t>(value) * scale) >> 32; }
+static inline int scale_ceil(int value, uint64_t scale) {
+  return (static_cast<uint64_t>(value) * scale + 0xFFFFFFFFu) >> 32;
+}
+static inline uint64_t scale_up(int dst, int src) { return ((static_cast<uint64_t>(dst) << 32) + src - 1) / src; }
+static inline uint64_t scale_down(int dst, int src) { return (static_cast<uint64_t>(dst) << 32) / src; }
+
+void Resampler::set_size(int src_width, int src_height, int dst_width, int dst_height, ResizeFilter filter) {
+  this->free_scratch_();
+  this->src_width_ = src_width;
+  this->src_height_ = src_height;
+  this->dst_width_ = dst_width;
+  this->dst_height_ = dst_height;
+  this->x_floor_scale_ = scale_up(dst_width, src_width);
+  this->x_ceil_scale_ = scale_down(dst_width, src_width);
+  this->y_floor_scale_ = scale_up(dst_height, src_height);
+  this->y_ceil_scale_ = scale_down(dst_height, src_height);
+  this->next_x_ = 0;
+  this->next_y_ = 0;
+  this->frame_ = 0;
+  this->next_dst_row_ = 0;
+  this->mode_ = MODE_NEAREST;
+
+  if (filter != RESIZE_FILTER_SMOOTH || (src_width == dst_width && src_height == dst_height)) {
+    return;
+  }
+  Mode mode;
+  if (dst_width <= src_width && dst_height <= src_height) {
+    mode = MODE_AREA;
+    this->scratch_size_ = dst_width * sizeof(Accumulator);
+  } else if (dst_width >= src_width && dst_height >= src_height) {
+    mode = MODE_BILINEAR;
+    this->scratch_size_ = 2 * src_width * 4;
+  } else {
+    ESP_LOGD(TAG, "Image is shrunk in one direction and enlarged in the other; using nearest neighbour");
+    return;
+  }
+  uint8_t *scratch = this->allocator_.allocate(this->scratch_size_);
+  if (scratch == nullptr) {
+    ESP_LOGW(TAG, "Could not allocate %zu bytes for resampling; using nearest neighbour", this->scratch_size_);
+    this->scratch_size_ = 0;
+    return;
+  }
+  if (mode == MODE_AREA) {
+    this->sums_ = reinterpret_cast<Accumulator *>(scratch);
+    memset(this->sums_, 0, this->scratch_size_);
+  } else {
+    this->rows_ = scratch;
+  }
+  this->mode_ = mode;
+}
+
+void Resampler::draw(int x, int y, int w, int h, const Color &color, int frame) {
+  if (this->mode_ != MODE_NEAREST) {
+    bool in_order = w == 1 && h == 1 && x == this->next_x_ && y == this->next_y_ &&
+                    (frame == this->frame_ || (x == 0 && y == 0));
+    if (!in_order) {
+      ESP_LOGD(TAG, "Pixels not in raster order; using nearest neighbour");
+      this->fall_back_();
+    } else {
+      this->frame_ = frame;
+      if (this->mode_ == MODE_AREA) {
+        this->push_area_(x, y, color);
+      } else {
+        this->push_bilinear_(x, y, color);
+      }
+      if (++this->next_x_ == this->src_width_) {
+        this->next_x_ = 0;
+        if (++this->next_y_ == this->src_height_) {
+          this->next_y_ = 0;
+          this->next_dst_row_ = 0;
+        }
+      }
+      return;
+    }
+  }
+  this->draw_nearest_(x, y, w, h, color, frame);
+}
+
+void Resampler::draw_nearest_(int x, int y, int w, int h, const Color &color, int frame) {
+  auto width = std::min(this->dst_width_, scale_ceil(x + w, this->x_ceil_scale_));
+  auto height = std::min(this->dst_height_, scale_ceil(y + h, this->y_ceil_scale_));
+  for (int i = scale_floor(x, this->x_floor_scale_); i < width; i++) {
+    for (int j = scale_floor(y, this->y_floor_scale_); j < height; j++) {
+      this->image_->draw_pixel_(i, j, color, frame);
+    }
+  }
+}
+
+void Resampler::push_area_(int x, int y, const Color &color) {
+  // Alpha-weighted sums, so that transparent pixels do not darken their neighbours.
+  Accumulator &acc = this->sums_[scale_floor(x, this->x_floor_scale_)];
+  acc.r += color.r * color.w;
+  acc.g += color.g * color.w;
+  acc.b += color.b * color.w;
+  acc.a += color.w;
+  acc.count++;
+  if (x == this->src_width_ - 1 &&
+      (y == this->src_height_ - 1 ||
+       scale_floor(y + 1, this->y_floor_scale_) != scale_floor(y, this->y_floor_scale_))) {
+    this->flush_area_row_();
+  }
+}
+
+void Resampler::flush_area_row_() {
+  int dst_y = scale_floor(this->next_y_, this->y_floor_scale_);
+  for (int i = 0; i < this->dst_width_; i++) {
+    Accumulator &acc = this->sums_[i];
+    if (acc.count == 0) {
+      continue;
+    }
+    Color color(0, 0, 0, 0);
+    if (acc.a != 0) {
+      color = Color(acc.r / acc.a, acc.g / acc.a, acc.b / acc.a, acc.a / acc.count);
+    }
+    this->image_->draw_pixel_(i, dst_y, color, this->frame_);
+  }
+  memset(this->sums_, 0, this->scratch_size_);
+}
+
+void Resampler::push_bilinear_(int x, int y, const Color &color) {
+  uint8_t *p = this->rows_ + ((y & 1) * this->src_width_ + x) * 4;
+  p[0] = color.r;
+  p[1] = color.g;
+  p[2] = color.b;
+  p[3] = color.w;
+  if (x == this->src_width_ - 1) {
+    this->emit_bilinear_rows_(y, y == this->src_height_ - 1);
+  }
+}
+
+void Resampler::emit_bilinear_rows_(int last_row, bool clamp) {
+  // Sample at pixel centres: src = (dst + 0.5) * src_size / dst_size - 0.5
+  const int64_t x_step = (static_cast<int64_t>(this->src_width_) << 16) / this->dst_width_;
+  const int64_t y_step = (static_cast<int64_t>(this->src_height_) << 16) / this->dst_height_;
+  const int64_t x_start = x_step / 2 - 0x8000;
+
+  while (this->next_dst_row_ < this->dst_height_) {
+    int64_t fy = std::max<int64_t>(0, this->next_dst_row_ * y_step + y_step / 2 - 0x8000);
+    int y0 = fy >> 16;
+    int y1 = std::min(y0 + 1, this->src_height_ - 1);
+    if (y1 > last_row) {
+      if (!clamp || y0 > last_row) {
+        return;
+      }
+      y1 = y0;
+    }
+    uint32_t wy = (fy >> 8) & 0xFF;
+    const uint8_t *row0 = this->rows_ + (y0 & 1) * this->src_width_ * 4;
+    const uint8_t *row1 = this->rows_ + (y1 & 1) * this->src_width_ * 4;
+
+    int64_t fx = x_start;
+    for (int i = 0; i < this->dst_width_; i++, fx += x_step) {
+      int64_t cx = std::max<int64_t>(0, fx);
+      int x0 = cx >> 16;
+      int x1 = std::min(x0 + 1, this->src_width_ - 1);
+      uint32_t wx = (cx >> 8) & 0xFF;
+      const uint8_t *p00 = row0 + x0 * 4;
+      const uint8_t *p01 = row0 + x1 * 4;
+      const uint8_t *p10 = row1 + x0 * 4;
+      const uint8_t *p11 = row1 + x1 * 4;
+      uint8_t c[4];
+      for (int k = 0; k < 4; k++) {
+        uint32_t top = p00[k] * (256 - wx) + p01[k] * wx;
+        uint32_t bottom = p10[k] * (256 - wx) + p11[k] * wx;
+        c[k] = (top * (256 - wy) + bottom * wy) >> 16;
+      }
+      this->image_->draw_pixel_(i, this->next_dst_row_, Color(c[0], c[1], c[2], c[3]), this->frame_);
+    }
+    this->next_dst_row_++;
+  }
+}
+
+void Resampler::fall_back_() {
+  if (this->mode_ == MODE_AREA) {
+    this->flush_area_row_();
+  } else if (this->mode_ == MODE_BILINEAR) {
+    if (this->next_y_ > 0) {
+      this->emit_bilinear_rows_(this->next_y_ - 1, true);
+    }
+    // Pixels of the row in progress have not been written yet
+    const uint8_t *row = this->rows_ + (this->next_y_ & 1) * this->src_width_ * 4;
+    for (int i = 0; i < this->next_x_; i++) {
+      const uint8_t *p = row + i * 4;
+      this->draw_nearest_(i, this->next_y_, 1, 1, Color(p[0], p[1], p[2], p[3]), this->frame_);
+    }
+  }
+  this->free_scratch_();
+  this->mode_ = MODE_NEAREST;
+}
+
+void Resampler::free_scratch_() {
+  uint8_t *scratch = this->sums_ ? reinterpret_cast<uint8_t *>(this->sums_) : this->rows_;
+  if (scratch) {
+    this->allocator_.deallocate(scratch, this->scratch_size_);
+  }
+  this->sums_ = nullptr;
+  this->rows_ = nullptr;
+  this->scratch_size_ = 0;
+}
+
+}  // namespace online_image
+}  // namespace esphome
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "esphome/core/color.h"
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace online_image {
+
+/**
+ * @brief Filter used when the decoded image does not have the size of the image buffer.
+ */
+enum ResizeFilter {
+  /** Nearest neighbour; every source pixel paints the buffer pixels it covers. */
+  RESIZE_FILTER_NEAREST,
+  /** Area averaging when shrinking, bilinear interpolation when enlarging. */
+  RESIZE_FILTER_SMOOTH,
+};
+
+class OnlineImage;
+
+/**
+ * @brief Scale decoded pixels into the image buffer.
+ *
+ * Coordinates are mapped with 32.32 fixed-point arithmetic, bilinear sampling positions
+ * with 16.16. With the smooth filter,
+ * pixels must arrive in raster order (left to right, top to bottom, frame after frame);
+ * they are accumulated in at most two rows of scratch memory and written out as soon as a
+ * destination row is complete. If pixels arrive out of order, whatever has been accumulated
+ * is written and the resampler falls back to nearest neighbour for the rest of the image.
+ */
+class Resampler {
+ public:
+  Resampler(OnlineImage *image) : image_(image) {}
+  ~Resampler() { this->free_scratch_(); }
+
+  /**
+   * @brief Set up the mapping from the decoded image to the image buffer.
+   *
+   * @param src_width Width of the decoded image.
+   * @param src_height Height of the decoded image.
+   * @param dst_width Width of the image buffer.
+   * @param dst_height Height of the image buffer.
+   * @param filter The filter to use, if the source can be delivered in raster order.
+   */
+  void set_size(int src_width, int src_height, int dst_width, int dst_height, ResizeFilter filter);
+
+  /**
+   * @brief Paint a rectangle of the decoded image.
+   *
+   * @param x The left-most coordinate of the rectangle, in decoded image coordinates.
+   * @param y The top-most coordinate of the rectangle, in decoded image coordinates.
+   * @param w The width of the rectangle.
+   * @param h The height of the rectangle.
+   * @param color The fill color.
+   * @param frame The frame to write to.
+   */
+  void draw(int x, int y, int w, int h, const Color &color, int frame);
+
+  /** Whether decoded pixels map one to one onto the image buffer. */
+  bool is_identity() const {
+    return this->mode_ == MODE_NEAREST && this->src_width_ == this->dst_width_ &&
+           this->src_height_ == this->dst_height_;
+  }
+
+ protected:
+  enum Mode {
+    MODE_NEAREST,
+    MODE_AREA,
+    MODE_BILINEAR,
+  };
+
+  struct Accumulator {
+    // Alpha-weighted, so 32 bits would overflow beyond 66052 source pixels per destination pixel.
+    uint64_t r, g, b;
+    uint32_t a, count;
+  };
+
+  void draw_nearest_(int x, int y, int w, int h, const Color &color, int frame);
+  void push_area_(int x, int y, const Color &color);
+  void push_bilinear_(int x, int y, const Color &color);
+  void flush_area_row_();
+  void emit_bilinear_rows_(int last_row, bool clamp);
+  /** Write out what has been accumulated and continue with nearest neighbour. */
+  void fall_back_();
+  void free_scratch_();
+
+  OnlineImage *image_;
+  RAMAllocator<uint8_t> allocator_{};
+  Mode mode_{MODE_NEAREST};
+
+  int src_width_{0};
+  int src_height_{0};
+  int dst_width_{0};
+  int dst_height_{0};
+  /** Destination pixels per source pixel, 32.32 fixed-point; rounded up to map coordinates rounding down. */
+  uint64_t x_floor_scale_{1ull << 32};
+  uint64_t y_floor_scale_{1ull << 32};
+  /** Rounded down, to map coordinates rounding up. */
+  uint64_t x_ceil_scale_{1ull << 32};
+  uint64_t y_ceil_scale_{1ull << 32};
+
+  /** Next pixel expected in raster order. */
+  int next_x_{0};
+  int next_y_{0};
+  int frame_{0};
+
+  /** Area mode: sums of the source pixels falling into each pixel of the current destination row. */
+  Accumulator *sums_{nullptr};
+  /** Bilinear mode: the last two source rows, RGBA. */
+  uint8_t *rows_{nullptr};
+  size_t scratch_size_{0};
+  /** Bilinear mode: next destination row to write. */
+  int next_dst_row_{0};
+};
+
+}  // namespace online_image
+}  // namespace esphome
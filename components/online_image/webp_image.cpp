@@ -3,7 +3,6 @@
 #ifdef USE_ONLINE_IMAGE_WEBP_SUPPORT
 
 #include "esphome/components/display/display_buffer.h"
-#include "esphome/core/application.h"
 #include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 
@@ -60,6 +59,10 @@ void draw_frame(ImageDecoder *decoder, uint8_t *pix, uint32_t width, uint32_t he
 
 int WebpDecoder::prepare(size_t download_size) {
   ImageDecoder::prepare(download_size);
+  if (download_size == DOWNLOAD_SIZE_UNKNOWN) {
+    // The download buffer grows while the image is being downloaded.
+    return 0;
+  }
   auto size = this->image_->resize_download_buffer(download_size);
   if (size < download_size) {
     ESP_LOGE(TAG, "Download buffer resize failed!");
@@ -115,8 +118,9 @@ int HOT WebpDecoder::decode(uint8_t *buffer, size_t size) {
   }
 
   // iterate over all frames
+  int previous_timestamp = 0;
   for (uint frame = 0; frame < animation_.frame_count; frame++) {
-    App.feed_wdt(); // feed watchdog
+    this->feed_wdt();
     uint8_t *pix;
     int timestamp;
     if (!WebPAnimDecoderGetNext(this->decoder_, &pix, &timestamp)) {
@@ -135,6 +139,9 @@ int HOT WebpDecoder::decode(uint8_t *buffer, size_t size) {
     }
 
     draw_frame(this, pix, this->animation_.canvas_width, this->animation_.canvas_height, frame);
+    // The timestamp is the time at which the frame ends.
+    this->set_frame_duration(frame, timestamp - previous_timestamp);
+    previous_timestamp = timestamp;
   }
 
   WebPAnimDecoderDelete(this->decoder_);